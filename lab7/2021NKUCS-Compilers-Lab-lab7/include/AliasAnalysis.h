@@ -0,0 +1,27 @@
+/**
+ * where addresses point, and whether two int accesses may overlap
+ */
+
+#ifndef __ALIAS_ANALYSIS_H__
+#define __ALIAS_ANALYSIS_H__
+
+class Operand;
+
+class AliasAnalysis
+{
+public:
+    enum { GLOBAL, PARAM, LOCAL, UNKNOWN };
+    // the object an address points into, and how far in when every index on the way is constant.
+    struct Location {
+        int kind = UNKNOWN;
+        Operand* base = nullptr;  // the address of a global, the alloca, or the slot of an array parameter
+        int offset = 0;
+        bool known = true;
+    };
+    // the array an address points into, param is set when it is a pointer loaded from a slot, which is returned instead.
+    static Operand* root(Operand* addr, bool& param);
+    static Location locate(Operand* addr);
+    static bool mayAlias(Operand* a, Operand* b);
+};
+
+#endif
@@ -51,6 +51,8 @@ public:
     ExprNode(SymbolEntry* symbolEntry, int kind = EXPR) : kind(kind), symbolEntry(symbolEntry){};
     Operand* getOperand() { return dst; };
     virtual int getValue() { return -1; };
+    // whether getValue() is the value of the expression.
+    virtual bool isConstant() { return false; };
     bool isExpr() const { return kind == EXPR; };
     bool isInitValueListExpr() const { return kind == INITVALUELISTEXPR; };
     bool isImplictCastExpr() const { return kind == IMPLICTCASTEXPR; };
@@ -70,6 +72,7 @@ public:
     enum {ADD, SUB, MUL, DIV, MOD, AND, OR, LESS, LESSEQUAL, GREATER, GREATEREQUAL, EQUAL, NOTEQUAL};
     BinaryExpr(SymbolEntry* se, int op, ExprNode* expr1, ExprNode* expr2);
     int getValue();
+    bool isConstant();
     void genCode();
 };
 
@@ -82,6 +85,7 @@ public:
     enum { NOT, SUB };
     UnaryExpr(SymbolEntry* se, int op, ExprNode* expr);
     int getValue();
+    bool isConstant() { return expr->isConstant(); };
     void genCode();
     int getOp() const { return op; };
     void setType(Type* type) { this->type = type; }
@@ -105,6 +109,7 @@ public:
         type = TypeSystem::intType;
     };
     int getValue();
+    bool isConstant() { return true; };
     void genCode();
 };
 
@@ -133,6 +138,7 @@ public:
     };
     void genCode();
     int getValue();
+    bool isConstant();
     ExprNode* getArrIdx() { return arrIdx; };
     Type* getType();
     bool isLeft() const { return left; };
@@ -161,7 +167,6 @@ public:
     bool isEmpty() { return childCnt == 0; };
     bool isFull();
     void genCode();
-    void fill();
 };
 
 class ImplictCastExpr : public ExprNode 
@@ -212,16 +217,9 @@ class DeclStmt : public StmtNode
 private:
     Id* id;
     ExprNode* expr;
+    void genArrayInit(Operand* addr);
 public:
-    DeclStmt(Id* id, ExprNode* expr = nullptr) : id(id) 
-    {
-        if (expr) 
-        {
-            this->expr = expr;
-            if (expr->isInitValueListExpr())
-                ((InitValueListExpr*)(this->expr))->fill();
-        }
-    };
+    DeclStmt(Id* id, ExprNode* expr = nullptr) : id(id), expr(expr){};
     void genCode();
     Id* getId() { return id; };
 };
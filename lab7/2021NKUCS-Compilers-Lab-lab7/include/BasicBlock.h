@@ -24,6 +24,8 @@ public:
     void insertBack(Instruction *);
     void insertBefore(Instruction *, Instruction *);
     void remove(Instruction *);
+    // remove the instruction, which then no longer uses its operands.
+    void erase(Instruction *);
     bool empty() const { return head->getNext() == head;}
     void output() const;
     bool succEmpty() const { return succ.empty(); };
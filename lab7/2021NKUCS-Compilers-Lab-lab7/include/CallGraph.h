@@ -0,0 +1,63 @@
+/**
+ * call graph of a unit, with what every function reads and writes
+ */
+
+#ifndef __CALL_GRAPH_H__
+#define __CALL_GRAPH_H__
+
+#include <map>
+#include <set>
+#include <vector>
+
+class Unit;
+class Function;
+class Instruction;
+class Operand;
+class SymbolEntry;
+
+class CallGraph
+{
+public:
+    // memory a function reads or writes, through itself or its callees.
+    struct Summary {
+        std::set<Operand*> reads, writes;           // globals, by their address
+        std::set<int> paramReads, paramWrites;      // arrays passed in as these parameters
+        bool io = false;        // calls an input or output routine of sylib
+        bool unknown = false;   // reaches memory it can't name, assume it reads and writes everything
+        // no writes and no io, so an unused call can go and equal calls give equal results.
+        bool pure() const { return writes.empty() && paramWrites.empty() && !io && !unknown; };
+    };
+
+private:
+    Unit* unit;
+    std::map<SymbolEntry*, Function*> functions;
+    std::map<Function*, std::vector<Function*>> callees;
+    std::map<Function*, Summary> summaries;
+    std::map<SymbolEntry*, Summary> routines;   // sylib and libc
+    std::vector<std::vector<Function*>> sccs;   // callees before callers
+    std::map<Function*, int> index, low;
+    std::vector<Function*> stack;
+    int counter;
+    void tarjan(Function* func);
+    bool summarize(Function* func);
+    Summary& routine(SymbolEntry* se);
+
+public:
+    CallGraph(Unit* unit);
+    void pass();
+    Function* getCallee(Instruction* call);
+    Summary& getSummary(Function* func) { return summaries[func]; };
+    // the summary of whatever a call goes to.
+    Summary& getSummary(Instruction* call);
+    std::vector<std::vector<Function*>>& getSCCs() { return sccs; };
+    enum { GLOBAL, PARAM, LOCAL, UNKNOWN };
+    /* What an address points into: a global, by its address, an array
+     * parameter, by the slot holding it and its number, or a local array or
+     * variable, by its alloca. */
+    static int root(Operand* addr, Operand*& base, int& param);
+    // whether the call may write the memory at addr, or read it when reads is set.
+    bool mayAccess(Instruction* call, Operand* addr, bool reads = false);
+    bool isPure(Instruction* call) { return getSummary(call).pure(); };
+};
+
+#endif
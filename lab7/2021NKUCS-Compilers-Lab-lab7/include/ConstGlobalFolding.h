@@ -0,0 +1,28 @@
+/**
+ * replace loads of globals nothing writes, at constant indices, by their
+ * initial values
+ */
+
+#ifndef __CONST_GLOBAL_FOLDING_H__
+#define __CONST_GLOBAL_FOLDING_H__
+
+#include <vector>
+
+class Unit;
+class Instruction;
+class Operand;
+class IdentifierSymbolEntry;
+
+class ConstGlobalFolding
+{
+private:
+    Unit* unit;
+    bool readOnly(Operand* addr);
+    void fold(Operand* addr, IdentifierSymbolEntry* se, int offset, bool known);
+
+public:
+    ConstGlobalFolding(Unit* unit);
+    void pass();
+};
+
+#endif
@@ -0,0 +1,46 @@
+/**
+ * sparse conditional constant propagation, through temporaries and the int
+ * slots only ever loaded from and stored to
+ */
+
+#ifndef __CONSTANT_PROPAGATION_H__
+#define __CONSTANT_PROPAGATION_H__
+
+#include <map>
+#include <set>
+#include <vector>
+
+class Unit;
+class Function;
+class BasicBlock;
+class Instruction;
+class Operand;
+
+class ConstantPropagation
+{
+private:
+    // what is known of an operand: nothing yet, a single value, or more than one.
+    struct Value {
+        enum { TOP, CONST, BOTTOM } kind = TOP;
+        int value = 0;
+    };
+    Unit* unit;
+    std::map<Operand*, Value> values;          // temporaries, and the slots below by their address
+    std::set<Operand*> slots;
+    std::set<BasicBlock*> executable;
+    std::vector<BasicBlock*> blocks;           // blocks newly found executable
+    std::vector<Instruction*> insts;           // instructions to visit again
+    Value get(Operand* op);
+    void lower(Operand* op, Value value);
+    void reach(BasicBlock* bb);
+    Value eval(Instruction* inst);
+    void visit(Instruction* inst);
+    void rewrite(Function* func);
+
+public:
+    ConstantPropagation(Unit* unit);
+    void pass();
+    void propagate(Function* func);
+};
+
+#endif
@@ -0,0 +1,30 @@
+/**
+ * drop the parameters a function never reads and the result no caller uses
+ */
+
+#ifndef __DEAD_ARGUMENT_ELIMINATION_H__
+#define __DEAD_ARGUMENT_ELIMINATION_H__
+
+#include <map>
+#include <vector>
+
+class Unit;
+class Function;
+class Instruction;
+class Operand;
+
+class DeadArgumentElimination
+{
+private:
+    Unit* unit;
+    std::map<Function*, std::vector<Instruction*>> calls;
+    std::vector<Instruction*> users(Function* func, Operand* param);
+    bool dead(Function* func, Operand* param, std::vector<Instruction*>& stores);
+    void pass(Function* func);
+
+public:
+    DeadArgumentElimination(Unit* unit);
+    void pass();
+};
+
+#endif
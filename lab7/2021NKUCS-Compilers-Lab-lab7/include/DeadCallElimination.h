@@ -0,0 +1,23 @@
+/**
+ * remove calls to pure functions whose result is never used
+ */
+
+#ifndef __DEAD_CALL_ELIMINATION_H__
+#define __DEAD_CALL_ELIMINATION_H__
+
+#include "CallGraph.h"
+
+class Unit;
+
+class DeadCallElimination
+{
+private:
+    Unit* unit;
+    CallGraph callGraph;
+
+public:
+    DeadCallElimination(Unit* unit);
+    void pass();
+};
+
+#endif
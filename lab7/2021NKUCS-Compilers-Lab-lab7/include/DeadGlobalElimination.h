@@ -0,0 +1,28 @@
+/**
+ * remove the functions main never reaches and the globals nothing reads
+ */
+
+#ifndef __DEAD_GLOBAL_ELIMINATION_H__
+#define __DEAD_GLOBAL_ELIMINATION_H__
+
+#include <string>
+#include <vector>
+
+class Unit;
+class Instruction;
+class Operand;
+
+class DeadGlobalElimination
+{
+private:
+    Unit* unit;
+    void removeFunctions();
+    bool writeOnly(Operand* addr, std::vector<Instruction*>& writes);
+    void removeGlobals();
+
+public:
+    DeadGlobalElimination(Unit* unit);
+    void pass();
+};
+
+#endif
@@ -0,0 +1,37 @@
+/**
+ * remove stores nothing reads before they are overwritten or the function
+ * returns
+ */
+
+#ifndef __DEAD_STORE_ELIMINATION_H__
+#define __DEAD_STORE_ELIMINATION_H__
+
+#include <set>
+#include <string>
+#include <vector>
+#include "CallGraph.h"
+
+class Unit;
+class Function;
+class BasicBlock;
+class Instruction;
+class Operand;
+
+class DeadStoreElimination
+{
+private:
+    Unit* unit;
+    CallGraph callGraph;
+    bool fills(Instruction* call, Operand* addr);
+    bool escapes(Operand* addr, bool& read, std::vector<Instruction*>& accesses);
+    void removeUnread(Function* func);
+    void removeOverwritten(Function* func);
+    std::string key(Operand* addr);
+    void removeLocalOverwritten(BasicBlock* bb);
+
+public:
+    DeadStoreElimination(Unit* unit);
+    void pass();
+};
+
+#endif
@@ -30,6 +30,10 @@ public:
     void insertBlock(BasicBlock *bb) { block_list.push_back(bb); };
     BasicBlock *getEntry() { return entry; };
     void remove(BasicBlock *bb);
+    // drop the blocks the entry no longer reaches, whether there were any.
+    bool removeUnreachable();
+    // the int allocas only loaded from and stored to.
+    std::set<Operand *> getSlots();
     void output() const;
     std::vector<BasicBlock *> &getBlockList(){return block_list;};
     iterator begin() { return block_list.begin(); };
@@ -0,0 +1,40 @@
+/**
+ * move global scalars only main uses onto its stack, and keep global scalars
+ * in a stack slot across loops that call nothing touching them
+ */
+
+#ifndef __GLOBAL_PROMOTION_H__
+#define __GLOBAL_PROMOTION_H__
+
+#include <map>
+#include <set>
+#include <vector>
+#include "CallGraph.h"
+#include "LoopAnalysis.h"
+
+class Unit;
+class Function;
+class BasicBlock;
+class Instruction;
+class Operand;
+
+class GlobalPromotion
+{
+private:
+    Unit* unit;
+    CallGraph callGraph;
+    Function* func;
+    bool direct(Operand* addr, Instruction* inst);
+    Operand* slot(Operand* init);
+    void redirect(BasicBlock* from, BasicBlock* to, BasicBlock* mid);
+    BasicBlock* split(BasicBlock* from, BasicBlock* to);
+    void localize();
+    void promote(LoopAnalysis::Loop* loop, Operand* addr);
+    void promote(Function* func);
+
+public:
+    GlobalPromotion(Unit* unit);
+    void pass();
+};
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * replace an expression, a load or a call computing what a dominating one
+ * already did by the result of that one
+ */
+
+#ifndef __GLOBAL_VALUE_NUMBERING_H__
+#define __GLOBAL_VALUE_NUMBERING_H__
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "CallGraph.h"
+#include "LoopAnalysis.h"
+
+class Unit;
+class BasicBlock;
+class Instruction;
+class Operand;
+
+class GlobalValueNumbering
+{
+private:
+    Unit* unit;
+    CallGraph callGraph;
+    LoopAnalysis analysis;
+    std::map<BasicBlock*, std::vector<BasicBlock*>> children;  // in the dominator tree
+    std::map<std::string, Operand*> table;                  // available expressions by their key
+    std::vector<std::pair<std::string, Operand*>> undo;      // what the table held before every change
+    std::string key(Operand* op);
+    std::string key(Instruction* inst);
+    void set(const std::string& k, Operand* value);
+    void kill(Instruction* inst);
+    void visit(BasicBlock* bb);
+    void number(Function* func);
+
+public:
+    GlobalValueNumbering(Unit* unit);
+    void pass();
+};
+
+#endif
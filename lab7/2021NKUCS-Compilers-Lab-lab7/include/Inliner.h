@@ -0,0 +1,38 @@
+/**
+ * inline calls to small functions, more eagerly inside loops
+ */
+
+#ifndef __INLINER_H__
+#define __INLINER_H__
+
+#include <map>
+#include <vector>
+
+class Unit;
+class Function;
+class BasicBlock;
+class Instruction;
+class Operand;
+
+class Inliner
+{
+private:
+    static const int maxSize = 30;          // instructions of a callee inlined anywhere
+    static const int maxLoopSize = 80;      // instructions of a callee inlined into a loop
+    static const int maxCallerSize = 3000;  // a caller stops growing here
+    Unit* unit;
+    std::map<Operand*, Operand*> operands;  // callee operand -> the operand standing for it at the call
+    Instruction* terminator(BasicBlock* bb);
+    std::vector<BasicBlock*> reachable(Function* func);
+    int size(Function* func);
+    bool inlinable(Function* func);
+    Function* callee(Instruction* call);
+    Operand* remap(Operand* op, std::vector<Operand*>& args);
+    void inlineCall(Instruction* call, Function* callee);
+
+public:
+    Inliner(Unit* unit);
+    void pass();
+};
+
+#endif
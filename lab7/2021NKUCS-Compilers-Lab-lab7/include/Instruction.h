@@ -18,6 +18,26 @@ public:
     bool isCond() const { return instType == COND; };
     bool isAlloc() const { return instType == ALLOCA; };
     bool isRet() const { return instType == RET; };
+    bool isBinary() const { return instType == BINARY; };
+    bool isLoad() const { return instType == LOAD; };
+    bool isStore() const { return instType == STORE; };
+    bool isCmp() const { return instType == CMP; };
+    bool isCall() const { return instType == CALL; };
+    bool isZext() const { return instType == ZEXT; };
+    bool isXor() const { return instType == XOR; };
+    bool isGep() const { return instType == GEP; };
+    bool isVLoad() const { return instType == VLOAD; };
+    bool isVStore() const { return instType == VSTORE; };
+    unsigned getOpcode() const { return opcode; };
+    std::vector<Operand*>& getOperands() { return operands; };
+    // the operand defined by this instruction, nullptr if there is none.
+    virtual Operand* getDef() { return nullptr; };
+    // the operands read by this instruction.
+    virtual std::vector<Operand*> getUse() { return std::vector<Operand*>(); };
+    void replaceUse(Operand* old, Operand* rep);
+    virtual void replaceDef(Operand* rep);
+    // a detached copy reading the same operands, its def should be replaced before use.
+    Instruction* copy();
     void setParent(BasicBlock*);
     void setNext(Instruction*);
     void setPrev(Instruction*);
@@ -31,13 +51,14 @@ public:
     MachineOperand* genMachineLabel(int block_no);
     virtual void genMachineCode(AsmBuilder*) = 0;
 protected:
+    virtual Instruction* clone() = 0;
     unsigned instType;
     unsigned opcode;
     Instruction* prev;
     Instruction* next;
     BasicBlock* parent;
     std::vector<Operand*> operands;
-    enum {BINARY, COND, UNCOND, RET, LOAD, STORE, CMP, ALLOCA, CALL, ZEXT, XOR, GEP};
+    enum {BINARY, COND, UNCOND, RET, LOAD, STORE, CMP, ALLOCA, CALL, ZEXT, XOR, GEP, VLOAD, VSTORE, VBINARY, VDUP, VBUILD, VREDUCE};
 };
 
 // meaningless instruction, used as the head node of the instruction list.
@@ -47,6 +68,8 @@ public:
     DummyInstruction() : Instruction(-1, nullptr){};
     void output() const {};
     void genMachineCode(AsmBuilder*){};
+protected:
+    Instruction* clone() { return new DummyInstruction(*this); };
 };
 
 class AllocaInstruction : public Instruction 
@@ -56,9 +79,13 @@ public:
     ~AllocaInstruction();
     void output() const;
     void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    SymbolEntry* getEntry() { return se; };
 
    private:
     SymbolEntry* se;
+protected:
+    Instruction* clone() { return new AllocaInstruction(*this); };
 };
 
 class LoadInstruction : public Instruction 
@@ -68,6 +95,10 @@ public:
     ~LoadInstruction();
     void output() const;
     void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return {operands[1]}; };
+protected:
+    Instruction* clone() { return new LoadInstruction(*this); };
 };
 
 class StoreInstruction : public Instruction 
@@ -77,6 +108,9 @@ public:
     ~StoreInstruction();
     void output() const;
     void genMachineCode(AsmBuilder*);
+    std::vector<Operand*> getUse() { return {operands[0], operands[1]}; };
+protected:
+    Instruction* clone() { return new StoreInstruction(*this); };
 };
 
 class BinaryInstruction : public Instruction 
@@ -86,7 +120,11 @@ public:
     ~BinaryInstruction();
     void output() const;
     void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return {operands[1], operands[2]}; };
     enum { SUB, ADD, AND, OR, MUL, DIV, MOD };
+protected:
+    Instruction* clone() { return new BinaryInstruction(*this); };
 };
 
 class CmpInstruction : public Instruction 
@@ -96,7 +134,11 @@ public:
     ~CmpInstruction();
     void output() const;
     void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return {operands[1], operands[2]}; };
     enum {E, NE, L, LE, G, GE };
+protected:
+    Instruction* clone() { return new CmpInstruction(*this); };
 };
 
 // unconditional branch
@@ -110,6 +152,7 @@ public:
     void genMachineCode(AsmBuilder*);
 protected:
     BasicBlock* branch;
+    Instruction* clone() { return new UncondBrInstruction(*this); };
 };
 
 // conditional branch
@@ -124,9 +167,11 @@ public:
     void setFalseBranch(BasicBlock*);
     BasicBlock* getFalseBranch();
     void genMachineCode(AsmBuilder*);
+    std::vector<Operand*> getUse() { return {operands[0]}; };
 protected:
     BasicBlock* true_branch;
     BasicBlock* false_branch;
+    Instruction* clone() { return new CondBrInstruction(*this); };
 };
 
 class RetInstruction : public Instruction 
@@ -136,6 +181,9 @@ public:
     ~RetInstruction();
     void output() const;
     void genMachineCode(AsmBuilder*);
+    std::vector<Operand*> getUse() { return operands; };
+protected:
+    Instruction* clone() { return new RetInstruction(*this); };
 };
 
 class CallInstruction : public Instruction 
@@ -148,6 +196,15 @@ public:
     ~CallInstruction();
     void output() const;
     void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return std::vector<Operand*>(operands.begin() + 1, operands.end()); };
+    SymbolEntry* getFuncSe() { return func; };
+    void setFuncSe(SymbolEntry* se) { func = se; };
+    // the result is returned right away and every argument goes in a register, so the call can be a b.
+    bool isSibling();
+    void replaceDef(Operand* rep) { Instruction::replaceDef(rep); dst = rep; };
+protected:
+    Instruction* clone() { return new CallInstruction(*this); };
 };
 
 class ZextInstruction : public Instruction 
@@ -159,6 +216,10 @@ public:
     ~ZextInstruction();
     void output() const;
     void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return {operands[1]}; };
+protected:
+    Instruction* clone() { return new ZextInstruction(*this); };
 };
 
 class XorInstruction : public Instruction 
@@ -168,6 +229,10 @@ public:
     ~XorInstruction();
     void output() const;
     void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return {operands[1]}; };
+protected:
+    Instruction* clone() { return new XorInstruction(*this); };
 };
 
 class GepInstruction : public Instruction 
@@ -183,11 +248,99 @@ public:
     ~GepInstruction();
     void output() const;
     void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return {operands[1], operands[2]}; };
     void setFirst() { first = true; };
+    bool isFirst() const { return first; };
+    bool isParamFirst() const { return paramFirst; };
     void setLast() { last = true; };
     Operand* getInit() const { return init; };
     void setInit(Operand* init) { this->init = init; };
+protected:
+    Instruction* clone() { return new GepInstruction(*this); };
+};
+
+// load four consecutive ints starting at src_addr into a vector.
+class VLoadInstruction : public Instruction 
+{
+public:
+    VLoadInstruction(Operand* dst, Operand* src_addr, BasicBlock* insert_bb = nullptr);
+    ~VLoadInstruction();
+    void output() const;
+    void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return {operands[1]}; };
+protected:
+    Instruction* clone() { return new VLoadInstruction(*this); };
+};
+
+class VStoreInstruction : public Instruction 
+{
+public:
+    VStoreInstruction(Operand* dst_addr, Operand* src, BasicBlock* insert_bb = nullptr);
+    ~VStoreInstruction();
+    void output() const;
+    void genMachineCode(AsmBuilder*);
+    std::vector<Operand*> getUse() { return {operands[0], operands[1]}; };
+protected:
+    Instruction* clone() { return new VStoreInstruction(*this); };
+};
 
+// lane-wise arithmetic.
+class VBinaryInstruction : public Instruction 
+{
+public:
+    VBinaryInstruction(unsigned opcode, Operand* dst, Operand* src1, Operand* src2, BasicBlock* insert_bb = nullptr);
+    ~VBinaryInstruction();
+    void output() const;
+    void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return {operands[1], operands[2]}; };
+    enum { ADD, SUB, MUL, MAX, MIN };
+protected:
+    Instruction* clone() { return new VBinaryInstruction(*this); };
+};
+
+// broadcast a scalar into every lane.
+class VDupInstruction : public Instruction 
+{
+public:
+    VDupInstruction(Operand* dst, Operand* src, BasicBlock* insert_bb = nullptr);
+    ~VDupInstruction();
+    void output() const;
+    void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return {operands[1]}; };
+protected:
+    Instruction* clone() { return new VDupInstruction(*this); };
+};
+
+// gather four scalars into the lanes of a vector.
+class VBuildInstruction : public Instruction 
+{
+public:
+    VBuildInstruction(Operand* dst, std::vector<Operand*> srcs, BasicBlock* insert_bb = nullptr);
+    ~VBuildInstruction();
+    void output() const;
+    void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return std::vector<Operand*>(operands.begin() + 1, operands.end()); };
+protected:
+    Instruction* clone() { return new VBuildInstruction(*this); };
+};
+
+// combine the lanes of a vector into a scalar, opcode is one of VBinaryInstruction::ADD, MUL, MAX, MIN.
+class VReduceInstruction : public Instruction 
+{
+public:
+    VReduceInstruction(unsigned opcode, Operand* dst, Operand* src, BasicBlock* insert_bb = nullptr);
+    ~VReduceInstruction();
+    void output() const;
+    void genMachineCode(AsmBuilder*);
+    Operand* getDef() { return operands[0]; };
+    std::vector<Operand*> getUse() { return {operands[1]}; };
+protected:
+    Instruction* clone() { return new VReduceInstruction(*this); };
 };
 
 #endif
\ No newline at end of file
@@ -23,6 +23,7 @@ private:
         int disp;    // displacement in stack
         int rreg;  // the real register mapped from virtual register if the vreg
                    // is not spilled to memory
+        bool vector;  // lives in the NEON register file
         std::set<MachineOperand*> defs;
         std::set<MachineOperand*> uses;
     };
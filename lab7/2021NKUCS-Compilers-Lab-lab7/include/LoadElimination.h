@@ -0,0 +1,41 @@
+/**
+ * forward what was stored or loaded at an address to later loads of it
+ */
+
+#ifndef __LOAD_ELIMINATION_H__
+#define __LOAD_ELIMINATION_H__
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "CallGraph.h"
+#include "LoopAnalysis.h"
+
+class Unit;
+class Function;
+class BasicBlock;
+class Instruction;
+class Operand;
+
+class LoadElimination
+{
+private:
+    typedef std::pair<Operand*, Operand*> Memory;  // an address and the value known to be there
+    Unit* unit;
+    CallGraph callGraph;
+    LoopAnalysis analysis;
+    std::map<BasicBlock*, std::vector<BasicBlock*>> children;  // in the dominator tree
+    std::map<std::string, Memory> table;
+    std::vector<std::pair<std::string, Memory>> undo;          // what the table held before every change
+    std::string key(Operand* addr);
+    void set(const std::string& k, Memory m);
+    void kill(Instruction* inst, const std::string& keep = "");
+    void visit(BasicBlock* bb);
+
+public:
+    LoadElimination(Unit* unit);
+    void pass();
+};
+
+#endif
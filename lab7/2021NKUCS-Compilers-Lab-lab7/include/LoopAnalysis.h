@@ -0,0 +1,48 @@
+/**
+ * dominators and natural loops of a function
+ */
+
+#ifndef __LOOP_ANALYSIS_H__
+#define __LOOP_ANALYSIS_H__
+
+#include <map>
+#include <set>
+#include <vector>
+
+class Function;
+class BasicBlock;
+
+class LoopAnalysis
+{
+public:
+    struct Loop {
+        BasicBlock* header;
+        std::set<BasicBlock*> blocks;
+        std::vector<BasicBlock*> latches;  // sources of the back edges
+        Loop* parent;                      // innermost enclosing loop
+        int depth;
+        bool inner;                        // contains no other loop
+    };
+
+private:
+    Function* func;
+    std::vector<BasicBlock*> order;  // reachable blocks in reverse post order
+    std::map<BasicBlock*, std::set<BasicBlock*>> doms;
+    std::vector<Loop*> loops;
+    void computeOrder();
+    void computeDominators();
+    void findLoops();
+
+public:
+    void pass(Function* func);
+    bool dominates(BasicBlock* a, BasicBlock* b);
+    // the immediate dominator, nullptr for the entry and unreachable blocks.
+    BasicBlock* idom(BasicBlock* bb);
+    bool reachable(BasicBlock* bb) { return doms.count(bb); };
+    std::vector<BasicBlock*>& getOrder() { return order; };
+    // loops are sorted from the innermost to the outermost.
+    std::vector<Loop*>& getLoops() { return loops; };
+    Loop* getLoop(BasicBlock* bb);
+};
+
+#endif
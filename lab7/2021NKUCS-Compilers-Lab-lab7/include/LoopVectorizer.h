@@ -0,0 +1,92 @@
+/**
+ * vectorize innermost counted loops over int arrays with NEON, including
+ * sum, product, max and min reductions into scalars. Loops that only fill or
+ * copy an array call the runtime instead.
+ */
+
+#ifndef __LOOP_VECTORIZER_H__
+#define __LOOP_VECTORIZER_H__
+
+#include <map>
+#include <set>
+#include <vector>
+#include "LoopAnalysis.h"
+
+class Unit;
+class Function;
+class BasicBlock;
+class Instruction;
+class Operand;
+class Type;
+class SymbolEntry;
+
+class LoopVectorizer
+{
+private:
+    enum { INVARIANT, INDEX, ADDR, VECTOR, REDUCTION };
+    // what an operand of the loop computes in iteration i.
+    struct Value {
+        int kind;
+        int offset;     // INDEX: i + offset, ADDR: &base[i + offset], REDUCTION: index into reductions
+        Operand* base;
+    };
+    struct Access {
+        Operand* addr;
+        Operand* base;
+        int offset;
+        bool store;
+    };
+    // a scalar only ever updated as var = var op x, or as if (x > var) var = x for max and min.
+    struct Reduction {
+        Operand* var;
+        int kind;           // VBinaryInstruction::ADD, MUL, MAX or MIN, -1 until known
+        Operand* load;      // the one read of var in the loop
+        bool stored;
+        Instruction* cmp;   // max and min: the compare against var
+        Operand* cand;      // max and min: the value compared with var
+        Operand* acc;       // the vector accumulating one partial result per lane
+    };
+    static const int width = 4;
+    static const int maxVectors = 12;  // size of the caller saved quad register file
+    static const int maxChecks = 6;
+    Unit* unit;
+    Function* func;
+    LoopAnalysis::Loop* loop;
+    BasicBlock *preheader, *header;
+    std::vector<BasicBlock*> body;      // the blocks of one iteration in order, without the max/min updates
+    std::set<BasicBlock*> updates;      // blocks that only do var = x for a max/min
+    Operand* iv;            // address of the induction variable
+    Operand* step;          // i + 1, stored back to iv
+    Instruction* cond;      // exit test
+    Operand* index;         // the side of the exit test that is i + c
+    Operand* bound;         // the side of the exit test that is invariant
+    std::set<Operand*> written;
+    std::vector<Reduction> reductions;
+    std::map<Operand*, int> reductionOf;
+    std::map<Operand*, Value> values;
+    std::vector<Access> accesses;
+    std::vector<std::pair<int, int>> checks;
+    std::map<Operand*, Operand*> vmap;   // loop operand -> its copy in the block being built
+    bool inLoop(Operand* op);
+    bool isInvariant(Operand* op);
+    bool isScalarVar(Operand* op);
+    bool classify(Instruction* inst);
+    bool classifyMinMax(Instruction* cmp, BasicBlock* update);
+    bool sameLanes(Operand* a, Operand* b);
+    bool analyze();
+    bool sameValue(Operand* a, Operand* b);
+    bool checkDependences();
+    Operand* materialize(Operand* op, BasicBlock* bb);
+    Operand* vectorOf(Operand* op, BasicBlock* bb, std::map<Operand*, Operand*>& dups);
+    void link(BasicBlock* from, BasicBlock* to);
+    void unlink(BasicBlock* from, BasicBlock* to);
+    void vectorize();
+    bool isIdiom();
+    void callIdiom();
+
+public:
+    LoopVectorizer(Unit* unit);
+    void pass();
+};
+
+#endif
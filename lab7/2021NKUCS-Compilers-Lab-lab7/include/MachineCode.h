@@ -32,10 +32,11 @@ private:
     int type;
     int val;            // value of immediate number   
     int reg_no;         // register no
+    bool vector;        // register of the NEON quad register file
     std::string label;  // address label
 public:
     enum { IMM, VREG, REG, LABEL };
-    MachineOperand(int tp, int val);
+    MachineOperand(int tp, int val, bool vector = false);
     MachineOperand(std::string label);
     bool operator==(const MachineOperand&) const;
     bool operator<(const MachineOperand&) const;
@@ -43,6 +44,7 @@ public:
     bool isReg() { return this->type == REG; };
     bool isVReg() { return this->type == VREG; };
     bool isLabel() { return this->type == LABEL; };
+    bool isVector() { return this->vector; };
     int getVal() { return this->val; };
     void setVal(int val) { this->val = val; };
     int getReg() { return this->reg_no; };
@@ -74,7 +76,7 @@ protected:
     void addUse(MachineOperand* ope) { use_list.push_back(ope); };
     // Print execution code after printing opcode
     void PrintCond();
-    enum instType { BINARY, LOAD, STORE, MOV, BRANCH, CMP, STACK };
+    enum instType { BINARY, LOAD, STORE, MOV, BRANCH, CMP, STACK, VLOAD, VSTORE, VBINARY, VDUP, VBUILD, VREDUCE };
 
 public:
     enum condType { EQ, NE, LT, LE, GT, GE, NONE };
@@ -87,6 +89,8 @@ public:
     void insertAfter(MachineInstruction*);
     MachineBlock* getParent() const { return parent; };
     bool isBX() const { return type == BRANCH && op == 2; };
+    // b to a function, the frame is torn down before it like before bx.
+    bool isTailCall() const { return type == BRANCH && op == 0 && use_list[0]->isLabel() && use_list[0]->getLabel()[0] == '@'; };
     bool isStore() const { return type == STORE; };
     bool isAdd() const { return type == BINARY && op == 0; };
 };
@@ -146,6 +150,55 @@ public:
     void output();
 };
 
+// vld1.32 {qd}, [rn]
+class VLoadMInstruction : public MachineInstruction 
+{
+public:
+    VLoadMInstruction(MachineBlock* p, MachineOperand* dst, MachineOperand* src, int cond = MachineInstruction::NONE);
+    void output();
+};
+
+// vst1.32 {qd}, [rn]
+class VStoreMInstruction : public MachineInstruction 
+{
+public:
+    VStoreMInstruction(MachineBlock* p, MachineOperand* src1, MachineOperand* src2, int cond = MachineInstruction::NONE);
+    void output();
+};
+
+class VBinaryMInstruction : public MachineInstruction 
+{
+public:
+    enum opType { VADD, VSUB, VMUL, VMAX, VMIN };
+    VBinaryMInstruction(MachineBlock* p, int op, MachineOperand* dst, MachineOperand* src1, MachineOperand* src2, int cond = MachineInstruction::NONE);
+    void output();
+};
+
+// vdup.32 qd, rn
+class VDupMInstruction : public MachineInstruction 
+{
+public:
+    VDupMInstruction(MachineBlock* p, MachineOperand* dst, MachineOperand* src, int cond = MachineInstruction::NONE);
+    void output();
+};
+
+// vmov.32 dd[x], rn for every lane
+class VBuildMInstruction : public MachineInstruction 
+{
+public:
+    VBuildMInstruction(MachineBlock* p, MachineOperand* dst, std::vector<MachineOperand*> srcs, int cond = MachineInstruction::NONE);
+    void output();
+};
+
+// fold the four lanes of a quad register pairwise through the scratch temp, then move lane 0 to rd.
+class VReduceMInstruction : public MachineInstruction 
+{
+public:
+    enum opType { VADD, VMUL, VMAX, VMIN };
+    VReduceMInstruction(MachineBlock* p, int op, MachineOperand* dst, MachineOperand* src, MachineOperand* temp, int cond = MachineInstruction::NONE);
+    void output();
+};
+
 class MachineBlock 
 {
 private:
@@ -196,6 +249,7 @@ private:
     std::set<int> saved_regs;          //寄存器信息
     SymbolEntry* sym_ptr;
     int paramsNum;
+    std::vector<MachineOperand*> paramOffsets;
 
 public:
     std::vector<MachineBlock*>& getBlocks() { return block_list; };
@@ -218,9 +272,15 @@ public:
         this->block_list.push_back(block);
     };
     void addSavedRegs(int regno) { saved_regs.insert(regno); };
+    // the frame size as an operand of add/sub sp, through r12 when it is no immediate.
+    MachineOperand* frameSize();
     void output();
     std::vector<MachineOperand*> getSavedRegs();
     int getParamsNum() const { return paramsNum; };
+    // the offset from fp of a parameter passed on the stack, fixed once the pushed registers are known.
+    MachineOperand* paramOffset(int paramNo);
+    // the globals whose address the function loads.
+    std::set<std::string> getGlobals();
     MachineUnit* getParent() const { return parent; };
 };
 
@@ -231,7 +291,10 @@ private:
     std::vector<SymbolEntry*> global_list;
     std::vector<MachineFunction*> func_list;
     void PrintGlobalDecl();
+    void PrintGlobalValue(IdentifierSymbolEntry* se);
     int gnumber;   //全局变量个数
+    int sincePool; // instructions printed since the last address pool
+    std::set<std::string> pool;     // the globals the function being printed uses
 
 public:
     std::vector<MachineFunction*>& getFuncs() { return func_list; };
@@ -242,7 +305,10 @@ public:
     void InsertFunc(MachineFunction* func) { func_list.push_back(func); };
     void output();
     void insertGlobal(SymbolEntry*);
+    void removeGlobal(SymbolEntry*);
     void printGlobal();
+    // a long function gets extra pools of addresses and constants on the way, ldr only reaches 4KB.
+    void reachPool();
     int getGnumber() const { return gnumber; };
 };
 
@@ -0,0 +1,37 @@
+/**
+ * cache the results of pure recursive functions of one or two ints, in a
+ * table for small arguments and in the runtime's hash table otherwise
+ */
+
+#ifndef __MEMOIZER_H__
+#define __MEMOIZER_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+class Unit;
+class Function;
+class BasicBlock;
+class Instruction;
+class Operand;
+class SymbolEntry;
+
+class Memoizer
+{
+private:
+    static const int tableSize = 4096;  // entries of the table of every function
+    Unit* unit;
+    Function* func;
+    bool pure(Function* func);
+    Operand* table(const std::string& name);
+    Operand* element(Operand* table, Operand* slot, BasicBlock* bb);
+    BasicBlock* branch(int opcode, Operand* a, Operand* b, BasicBlock* bb, BasicBlock* t, BasicBlock* f);
+    void memoize(Function* func, int id);
+
+public:
+    Memoizer(Unit* unit);
+    void pass();
+};
+
+#endif
@@ -30,6 +30,12 @@ public:
     std::string toStr() const;
     SymbolEntry * getEntry() { return se; };
     Instruction* getDef() { return def; };
+    // whether this is the address of a global int.
+    bool isGlobalInt();
+    // a new int constant.
+    static Operand* constant(int value);
+    // a new temporary of type.
+    static Operand* temporary(Type* type);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+/**
+ * move expressions computed on every path out of a point up to that point,
+ * loop invariant ones and loads up to a preheader
+ */
+
+#ifndef __PARTIAL_REDUNDANCY_ELIMINATION_H__
+#define __PARTIAL_REDUNDANCY_ELIMINATION_H__
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "CallGraph.h"
+#include "LoopAnalysis.h"
+
+class Unit;
+class Function;
+class BasicBlock;
+class Instruction;
+class Operand;
+
+class PartialRedundancyElimination
+{
+private:
+    Unit* unit;
+    Function* func;
+    CallGraph callGraph;
+    LoopAnalysis analysis;
+    std::string key(Instruction* inst);
+    Instruction* point(BasicBlock* bb);
+    BasicBlock* preheader(LoopAnalysis::Loop* loop);
+    bool invariant(LoopAnalysis::Loop* loop, Operand* op);
+    bool movable(LoopAnalysis::Loop* loop, Instruction* inst, std::vector<Instruction*>& writes);
+    void hoist(LoopAnalysis::Loop* loop);
+    void anticipate();
+
+public:
+    PartialRedundancyElimination(Unit* unit);
+    void pass();
+};
+
+#endif
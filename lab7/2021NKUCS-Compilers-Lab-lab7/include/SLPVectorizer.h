@@ -0,0 +1,43 @@
+/**
+ * pack straight-line stores to four adjacent int elements into NEON
+ */
+
+#ifndef __SLP_VECTORIZER_H__
+#define __SLP_VECTORIZER_H__
+
+#include <map>
+#include <vector>
+#include "CallGraph.h"
+
+class Unit;
+class BasicBlock;
+class Instruction;
+class Operand;
+
+class SLPVectorizer
+{
+private:
+    enum { DUP, LOAD, BINARY, BUILD };
+    static const int width = 4;
+    Unit* unit;
+    CallGraph callGraph;
+    BasicBlock* bb;
+    std::map<Instruction*, int> position;
+    std::vector<Instruction*> loads;    // scalar loads replaced by the pack being built
+    bool element(Operand* addr, Operand*& base, int& index);
+    bool sameValue(Operand* a, Operand* b);
+    bool mayAlias(Operand* a, int na, Operand* b, int nb);
+    bool clobbered(Instruction* from, Instruction* to, Operand* addr, bool reads);
+    int kindOf(std::vector<Operand*>& lanes);
+    void collect(std::vector<Operand*> lanes);
+    Operand* emit(std::vector<Operand*> lanes, Instruction* pos);
+    void erase(Instruction* inst);
+    bool pack(std::vector<Instruction*>& stores);
+    void pass(BasicBlock* bb);
+
+public:
+    SLPVectorizer(Unit* unit);
+    void pass();
+};
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * clone functions for the constant arguments they are called with, and fold
+ * the constants through the copies
+ */
+
+#ifndef __SPECIALIZER_H__
+#define __SPECIALIZER_H__
+
+#include <map>
+#include <utility>
+#include <vector>
+#include "ConstantPropagation.h"
+
+class Unit;
+class Function;
+class BasicBlock;
+class Instruction;
+class Operand;
+
+class Specializer
+{
+private:
+    typedef std::vector<std::pair<int, int>> Signature;  // parameter number -> value
+    static const int maxSize = 200;     // instructions of a function worth cloning
+    static const int maxClones = 4;     // copies of one function
+    static const int maxGrowth = 2000;  // instructions all copies add to the unit
+    Unit* unit;
+    ConstantPropagation constantPropagation;
+    std::map<Operand*, Operand*> operands;  // operand of the function -> operand of the copy
+    int size(Function* func);
+    std::map<int, Operand*> slots(Function* func);
+    Signature signature(Instruction* call, std::map<int, Operand*>& slots);
+    Operand* remap(Operand* op);
+    Function* clone(Function* func, const Signature& sig, std::map<int, Operand*>& slots, int id);
+    void replaceAll(Operand* old, Operand* rep);
+
+public:
+    Specializer(Unit* unit);
+    void pass();
+};
+
+#endif
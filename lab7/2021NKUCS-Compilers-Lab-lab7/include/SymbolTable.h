@@ -103,7 +103,7 @@ private:
     int label;
     bool initial;
     bool sysy;
-    int* arrayValue;
+    std::map<int, int> arrayValue;  // the non-zero elements of an initialized array, by index
     bool allZero;
     int paramNo;
     bool constant;
@@ -122,13 +122,15 @@ public:
     Operand* getAddr() { return addr; };
     void setValue(int value);
     int getValue() const { return value; };
-    void setArrayValue(int* arrayValue);
-    int* getArrayValue() const { return arrayValue; };
+    void setArrayValue(int index, int value);
+    int getArrayValue(int index) const;
+    std::map<int, int>& getArrayValues() { return arrayValue; };
     int getLabel() const { return label; };
     void setLabel() { label = SymbolTable::getLabel(); };
     void setAllZero() { allZero = true; };
     bool isAllZero() const { return allZero; };
     int getParamNo() const { return paramNo; };
+    void setParamNo(int paramNo) { this->paramNo = paramNo; };
     void setConst() { constant = true;};
     bool getConst() const { return constant; };
 
@@ -0,0 +1,29 @@
+/**
+ * turn self calls in tail position into a branch back to the function body
+ */
+
+#ifndef __TAIL_RECURSION_H__
+#define __TAIL_RECURSION_H__
+
+#include <vector>
+
+class Unit;
+class Function;
+class BasicBlock;
+class Instruction;
+class Operand;
+
+class TailRecursion
+{
+private:
+    Unit* unit;
+    Function* func;
+    bool tailCall(Instruction* call, Instruction*& op);
+    void pass(Function* func);
+
+public:
+    TailRecursion(Unit* unit);
+    void pass();
+};
+
+#endif
@@ -9,7 +9,7 @@ class Type {
     int kind;
 
    protected:
-    enum { INT, VOID, FUNC, PTR, ARRAY, STRING };
+    enum { INT, VOID, FUNC, PTR, ARRAY, STRING, VECTOR };
     int size;
 
    public:
@@ -22,6 +22,7 @@ class Type {
     bool isPtr() const { return kind == PTR; };
     bool isArray() const { return kind == ARRAY; };
     bool isString() const { return kind == STRING; };
+    bool isVector() const { return kind == VECTOR; };
     int getKind() const { return kind; };
     int getSize() const { return size; };
 };
@@ -111,18 +112,36 @@ class PointerType : public Type {
     Type* getType() const { return valueType; };
 };
 
+// fixed length vector of int, lives in a NEON quad register.
+class VectorType : public Type {
+   private:
+    Type* elementType;
+    int length;
+
+   public:
+    VectorType(Type* elementType, int length)
+        : Type(Type::VECTOR), elementType(elementType), length(length) {
+        size = elementType->getSize() * length;
+    };
+    std::string toStr();
+    int getLength() const { return length; };
+    Type* getElementType() const { return elementType; };
+};
+
 class TypeSystem {
    private:
     static IntType commonInt;
     static IntType commonBool;
     static VoidType commonVoid;
     static IntType commonConstInt;
+    static VectorType commonVectorInt;
 
    public:
     static Type* intType;
     static Type* voidType;
     static Type* boolType;
     static Type* constIntType;
+    static Type* vectorIntType;
 };
 
 #endif
@@ -1,6 +1,8 @@
 #ifndef __UNIT_H__
 #define __UNIT_H__
 
+#include <map>
+#include <string>
 #include <vector>
 #include "Function.h"
 #include "SymbolTable.h"
@@ -13,14 +15,20 @@ class Unit {
     std::vector<SymbolEntry*> global_list;
     std::vector<Function*> func_list;
     std::vector<SymbolEntry*> declare_list;
+    std::map<std::string, SymbolEntry*> routines;
 
    public:
     Unit() = default;
     ~Unit();
     void insertFunc(Function*);
+    void insertFunc(Function* func, Function* after);
     void removeFunc(Function*);
     void insertGlobal(SymbolEntry*);
+    void removeGlobal(SymbolEntry*);
+    std::vector<SymbolEntry*>& getGlobals() { return global_list; };
     void insertDeclare(SymbolEntry*);
+    // the library routine name returning ret and taking params, declared once.
+    SymbolEntry* declare(const std::string& name, Type* ret, const std::vector<Type*>& params);
     void output() const;
     iterator begin() { return func_list.begin(); };
     iterator end() { return func_list.end(); };
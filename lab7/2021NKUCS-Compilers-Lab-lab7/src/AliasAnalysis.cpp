@@ -0,0 +1,110 @@
+#include "AliasAnalysis.h"
+#include "Instruction.h"
+#include "Type.h"
+
+/* An address is followed back through element addresses to a global, an
+ * alloca, or a pointer loaded from a slot. A slot stored once holds the
+ * pointer it was given, which for a function's own array parameter is the
+ * parameter and for an inlined one is the caller's address, followed on.
+ * Distinct globals and allocas never overlap, a parameter may point into a
+ * global or another parameter but never into a local of the function, and
+ * within one object constant offsets tell accesses apart. */
+
+Operand* AliasAnalysis::root(Operand* addr, bool& param)
+{
+    param = false;
+    Instruction* def = addr->getDef();
+    while (def && def->isGep())
+    {
+        addr = def->getOperands()[1];
+        def = addr->getDef();
+    }
+    if (def && def->isLoad())
+    {
+        param = true;
+        return def->getOperands()[1];
+    }
+    return addr;
+}
+
+AliasAnalysis::Location AliasAnalysis::locate(Operand* addr)
+{
+    Location loc;
+    Instruction* def = addr->getDef();
+    while (def && def->isGep())
+    {
+        GepInstruction* gep = (GepInstruction*)def;
+        std::vector<Operand*>& ops = gep->getOperands();
+        Type* type = ((PointerType*)ops[1]->getType())->getType();
+        int size;
+        if (gep->isParamFirst())
+            size = type->getSize() / 8;
+        else if (type->isArray())
+            size = ((ArrayType*)type)->getElementType()->getSize() / 8;
+        else
+            return loc;
+        SymbolEntry* index = ops[2]->getEntry();
+        if (index->isConstant())
+            loc.offset += ((ConstantSymbolEntry*)index)->getValue() * size;
+        else
+            loc.known = false;
+        addr = ops[1];
+        def = addr->getDef();
+    }
+    SymbolEntry* se = addr->getEntry();
+    if (!def)
+    {
+        if (se->isVariable() && ((IdentifierSymbolEntry*)se)->isGlobal())
+        {
+            loc.kind = GLOBAL;
+            loc.base = addr;
+        }
+        return loc;
+    }
+    if (def->isAlloc())
+    {
+        loc.kind = LOCAL;
+        loc.base = addr;
+        return loc;
+    }
+    if (!def->isLoad())
+        return loc;
+    Operand* slot = def->getOperands()[1];
+    if (!slot->getDef() || !slot->getDef()->isAlloc())
+        return loc;
+    Operand* stored = nullptr;
+    for (auto use = slot->use_begin(); use != slot->use_end(); use++)
+    {
+        std::vector<Operand*>& ops = (*use)->getOperands();
+        if ((*use)->isLoad() && ops[1] == slot)
+            continue;
+        if (!(*use)->isStore() || ops[0] != slot || ops[1] == slot || stored)
+            return loc;
+        stored = ops[1];
+    }
+    if (!stored)
+        return loc;
+    SymbolEntry* stored_se = stored->getEntry();
+    if (stored_se->isVariable() && ((IdentifierSymbolEntry*)stored_se)->isParam())
+    {
+        loc.kind = PARAM;
+        loc.base = slot;
+        return loc;
+    }
+    Location from = locate(stored);
+    from.offset += loc.offset;
+    from.known = from.known && loc.known;
+    return from;
+}
+
+bool AliasAnalysis::mayAlias(Operand* a, Operand* b)
+{
+    Location x = locate(a), y = locate(b);
+    if (x.kind == UNKNOWN || y.kind == UNKNOWN)
+        return true;
+    if (x.base == y.base && x.kind == y.kind)
+        return !x.known || !y.known || x.offset == y.offset;
+    if (x.kind == PARAM || y.kind == PARAM)
+        return x.kind != LOCAL && y.kind != LOCAL;
+    return false;
+}
@@ -1,4 +1,5 @@
 #include "Ast.h"
+#include <map>
 #include <stack>
 #include <string>
 #include "IRBuilder.h"
@@ -486,78 +487,7 @@ void DeclStmt::genCode()
         if (expr) 
         {
             if (expr->isInitValueListExpr()) 
-            {
-                Operand* init = nullptr;
-                BasicBlock* bb = builder->getInsertBB();
-                ExprNode* temp = expr;
-                std::stack<ExprNode*> stk;
-                std::vector<int> idx;
-                idx.push_back(0);
-                while (temp) 
-                {
-                    if (temp->isInitValueListExpr()) 
-                    {
-                        stk.push(temp);
-                        idx.push_back(0);
-                        temp = ((InitValueListExpr*)temp)->getExpr();
-                        continue;
-                    } 
-                    else 
-                    {
-                        temp->genCode();
-                        Type* type =
-                            ((ArrayType*)(se->getType()))->getElementType();
-                        Operand* tempSrc = addr;
-                        Operand* tempDst;
-                        Operand* index;
-                        bool flag = true;
-                        int i = 1;
-                        while (true) {
-                            tempDst = new Operand(new TemporarySymbolEntry(
-                                new PointerType(type),
-                                SymbolTable::getLabel()));
-                            index = (new Constant(new ConstantSymbolEntry(
-                                         TypeSystem::intType, idx[i++])))
-                                        ->getOperand();
-                            auto gep =
-                                new GepInstruction(tempDst, tempSrc, index, bb);
-                            gep->setInit(init);
-                            if (flag) {
-                                gep->setFirst();
-                                flag = false;
-                            }
-                            if (type == TypeSystem::intType ||
-                                type == TypeSystem::constIntType){
-                                gep->setLast();
-                                init = tempDst;
-                                break;
-                            }
-                            type = ((ArrayType*)type)->getElementType();
-                            tempSrc = tempDst;
-                        }
-                        new StoreInstruction(tempDst, temp->getOperand(), bb);
-                    }
-                    while (true) 
-                    {
-                        if (temp->getNext()) 
-                        {
-                            temp = (ExprNode*)(temp->getNext());
-                            idx[idx.size() - 1]++;
-                            break;
-                        } 
-                        else 
-                        {
-                            temp = stk.top();
-                            stk.pop();
-                            idx.pop_back();
-                            if (stk.empty())
-                                break;
-                        }
-                    }
-                    if (stk.empty())
-                        break;
-                }
-            } 
+                genArrayInit(addr);
             else 
             {
                 BasicBlock* bb = builder->getInsertBB();
@@ -578,6 +508,107 @@ void DeclStmt::genCode()
     }
 }
 
+// the elements an initializer list gives, by their index in the array.
+static void flatten(ExprNode* list, int offset, std::map<int, ExprNode*>& elements)
+{
+    Type* type = ((ArrayType*)(list->getType()))->getElementType();
+    int step = type->getSize() / TypeSystem::intType->getSize();
+    ExprNode* temp = ((InitValueListExpr*)list)->getExpr();
+    while (temp) 
+    {
+        if (temp->isInitValueListExpr())
+            flatten(temp, offset, elements);
+        else
+            elements[offset] = temp;
+        offset += step;
+        temp = (ExprNode*)(temp->getNext());
+    }
+}
+
+// memset and memcpy of the C library, both taking a byte count.
+static SymbolEntry* libcFunc(const char* name)
+{
+    Type* array = new PointerType(TypeSystem::intType);
+    Type* arg = std::string(name) == "memcpy" ? array : TypeSystem::intType;
+    return unit.declare(name, TypeSystem::voidType, {array, arg, TypeSystem::intType});
+}
+
+/* Writing the elements of a local array one by one costs about six
+ * instructions each, an element address alone takes four. Larger arrays are
+ * cleared with memset and only the non-zero elements stored, or copied from
+ * a template in .rodata so that only the elements known at run time are
+ * stored. Whichever is estimated shortest is used. */
+void DeclStmt::genArrayInit(Operand* addr)
+{
+    const int storeCost = 6, callCost = 20;
+    Type* type = ((PointerType*)addr->getType())->getType();
+    int size = type->getSize() / TypeSystem::intType->getSize();
+    std::map<int, ExprNode*> elements;
+    flatten(expr, 0, elements);
+    int nonZero = 0, runtime = 0;
+    for (auto& it : elements)
+        if (!it.second->isConstant())
+            runtime++;
+        else if (it.second->getValue() != 0)
+            nonZero++;
+    int storeAll = storeCost * size;
+    int clear = callCost + size / 4 + storeCost * (nonZero + runtime);
+    int copy = callCost + size / 2 + storeCost * runtime;
+
+    BasicBlock* bb = builder->getInsertBB();
+    Operand* base = new Operand(new TemporarySymbolEntry(new PointerType(TypeSystem::intType), SymbolTable::getLabel()));
+    Operand* zero = new Operand(new ConstantSymbolEntry(TypeSystem::intType, 0));
+    Operand* bytes = new Operand(new ConstantSymbolEntry(TypeSystem::intType, size * 4));
+    GepInstruction* gep = new GepInstruction(base, addr, zero, bb);
+    gep->setFirst();
+    // the elements left to store, with nullptr for a zero.
+    std::map<int, ExprNode*> stores;
+    if (clear < storeAll && clear <= copy) 
+    {
+        new CallInstruction(nullptr, libcFunc("memset"), {base, zero, bytes}, bb);
+        for (auto& it : elements)
+            if (!it.second->isConstant() || it.second->getValue() != 0)
+                stores.insert(it);
+    } 
+    else if (copy < storeAll) 
+    {
+        IdentifierSymbolEntry* se = new IdentifierSymbolEntry(type, "__init." + std::to_string(SymbolTable::getLabel()), globals->getLevel());
+        se->setConst();
+        for (auto& it : elements)
+            if (it.second->isConstant())
+                se->setArrayValue(it.first, it.second->getValue());
+            else
+                stores.insert(it);
+        SymbolEntry* addr_se = new IdentifierSymbolEntry(*se);
+        addr_se->setType(new PointerType(type));
+        se->setAddr(new Operand(addr_se));
+        unit.insertGlobal(se);
+        mUnit.insertGlobal(se);
+        Operand* src = new Operand(new TemporarySymbolEntry(new PointerType(TypeSystem::intType), SymbolTable::getLabel()));
+        gep = new GepInstruction(src, se->getAddr(), zero, bb);
+        gep->setFirst();
+        new CallInstruction(nullptr, libcFunc("memcpy"), {base, src, bytes}, bb);
+    } 
+    else 
+    {
+        for (int i = 0; i < size; i++)
+            stores[i] = elements.count(i) ? elements[i] : nullptr;
+    }
+    for (auto& it : stores) 
+    {
+        Operand* src = zero;
+        if (it.second) 
+        {
+            it.second->genCode();
+            src = it.second->getOperand();
+        }
+        Operand* dst = new Operand(new TemporarySymbolEntry(new PointerType(TypeSystem::intType), SymbolTable::getLabel()));
+        Operand* index = new Operand(new ConstantSymbolEntry(TypeSystem::intType, it.first));
+        new GepInstruction(dst, base, index, bb, true);
+        new StoreInstruction(dst, src, bb);
+    }
+}
+
 void ReturnStmt::genCode() 
 {
     // Todo
@@ -860,6 +891,13 @@ UnaryExpr::UnaryExpr(SymbolEntry* se, int op, ExprNode* expr)
     }
 };
 
+bool BinaryExpr::isConstant() 
+{
+    if ((op == DIV || op == MOD) && expr2->isConstant() && expr2->getValue() == 0)
+        return false;
+    return expr1->isConstant() && expr2->isConstant();
+}
+
 int UnaryExpr::getValue() 
 {
     int value = 0;
@@ -884,6 +922,11 @@ int Id::getValue()
     return ((IdentifierSymbolEntry*)symbolEntry)->getValue();
 }
 
+bool Id::isConstant() 
+{
+    return symbolEntry->getType()->isInt() && ((IdentifierSymbolEntry*)symbolEntry)->getConst();
+}
+
 void InitValueListExpr::addExpr(ExprNode* expr) 
 {
     if (this->expr == nullptr) 
@@ -905,27 +948,6 @@ bool InitValueListExpr::isFull()
     return childCnt == type->getLength();
 }
 
-void InitValueListExpr::fill() 
-{
-    Type* type = ((ArrayType*)(this->getType()))->getElementType();
-    if (type->isArray()) 
-    {
-        while (!isFull())
-            this->addExpr(new InitValueListExpr(new ConstantSymbolEntry(type)));
-        ExprNode* temp = expr;
-        while (temp) {
-            ((InitValueListExpr*)temp)->fill();
-            temp = (ExprNode*)(temp->getNext());
-        }
-    }
-    if (type->isInt()) 
-    {
-        while (!isFull())
-            this->addExpr(new Constant(new ConstantSymbolEntry(type, 0)));
-        return;
-    }
-}
-
 void ImplictCastExpr::genCode() 
 {
     expr->genCode();
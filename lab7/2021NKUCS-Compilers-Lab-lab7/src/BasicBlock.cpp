@@ -32,6 +32,12 @@ void BasicBlock::remove(Instruction* inst) {
     inst->getNext()->setPrev(inst->getPrev());
 }
 
+void BasicBlock::erase(Instruction* inst) {
+    remove(inst);
+    for (auto use : inst->getUse())
+        use->removeUse(inst);
+}
+
 void BasicBlock::output() const {
     fprintf(yyout, "B%d:", no);
 
@@ -0,0 +1,248 @@
+#include "CallGraph.h"
+#include <algorithm>
+#include <string>
+#include "Instruction.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* Functions are summarized one strongly connected component at a time,
+ * callees first, so every call outside the component already has its
+ * summary. Inside a component the summaries are recomputed until none
+ * grows. A call maps the arrays its callee reads or writes through a
+ * parameter back to what the argument points into in the caller. */
+
+CallGraph::CallGraph(Unit* unit)
+{
+    this->unit = unit;
+}
+
+void CallGraph::pass()
+{
+    functions.clear();
+    callees.clear();
+    summaries.clear();
+    sccs.clear();
+    index.clear();
+    low.clear();
+    counter = 0;
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        functions[(*it)->getSymPtr()] = *it;
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        for (auto bb : (*it)->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            {
+                Function* callee = inst->isCall() ? getCallee(inst) : nullptr;
+                std::vector<Function*>& list = callees[*it];
+                if (callee && std::find(list.begin(), list.end(), callee) == list.end())
+                    list.push_back(callee);
+            }
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        if (!index.count(*it))
+            tarjan(*it);
+    for (auto& scc : sccs)
+    {
+        bool change = true;
+        while (change)
+        {
+            change = false;
+            for (auto func : scc)
+                if (summarize(func))
+                    change = true;
+        }
+    }
+}
+
+void CallGraph::tarjan(Function* func)
+{
+    index[func] = low[func] = counter++;
+    stack.push_back(func);
+    for (auto callee : callees[func])
+    {
+        if (!index.count(callee))
+        {
+            tarjan(callee);
+            low[func] = std::min(low[func], low[callee]);
+        }
+        else if (std::find(stack.begin(), stack.end(), callee) != stack.end())
+            low[func] = std::min(low[func], index[callee]);
+    }
+    if (low[func] != index[func])
+        return;
+    std::vector<Function*> scc;
+    Function* top;
+    do
+    {
+        top = stack.back();
+        stack.pop_back();
+        scc.push_back(top);
+    } while (top != func);
+    sccs.push_back(scc);
+}
+
+Function* CallGraph::getCallee(Instruction* call)
+{
+    auto it = functions.find(((CallInstruction*)call)->getFuncSe());
+    return it == functions.end() ? nullptr : it->second;
+}
+
+CallGraph::Summary& CallGraph::getSummary(Instruction* call)
+{
+    Function* callee = getCallee(call);
+    if (callee)
+        return summaries[callee];
+    return routine(((CallInstruction*)call)->getFuncSe());
+}
+
+// the library routines, fill and copy only touch their arrays, everything else does io.
+CallGraph::Summary& CallGraph::routine(SymbolEntry* se)
+{
+    if (routines.count(se))
+        return routines[se];
+    Summary& s = routines[se];
+    std::string name = se->toStr().substr(1);
+    if (name == "memset" || name == "_sysy_fill")
+        s.paramWrites = {0};
+    else if (name == "memcpy" || name == "_sysy_copy")
+    {
+        s.paramWrites = {0};
+        s.paramReads = {1};
+    }
+    else
+    {
+        s.io = true;
+        if (name == "getarray")
+            s.paramWrites = {0};
+        else if (name == "putarray")
+            s.paramReads = {1};
+    }
+    return s;
+}
+
+int CallGraph::root(Operand* addr, Operand*& base, int& param)
+{
+    param = -1;
+    Instruction* def = addr->getDef();
+    while (def && def->isGep())
+    {
+        addr = def->getOperands()[1];
+        def = addr->getDef();
+    }
+    base = addr;
+    SymbolEntry* se = addr->getEntry();
+    if (!def)
+        return se->isVariable() && ((IdentifierSymbolEntry*)se)->isGlobal() ? GLOBAL : UNKNOWN;
+    if (def->isAlloc())
+        return LOCAL;
+    if (def->isLoad())
+    {
+        // an array parameter is stored to a slot of its own on entry and loaded from it. A slot
+        // inlined from a callee keeps the callee's entry, so it is the single store that tells.
+        Operand* slot = def->getOperands()[1];
+        if (!slot->getDef() || !slot->getDef()->isAlloc())
+            return UNKNOWN;
+        Operand* stored = nullptr;
+        for (auto use = slot->use_begin(); use != slot->use_end(); use++)
+        {
+            std::vector<Operand*>& ops = (*use)->getOperands();
+            if ((*use)->isLoad() && ops[1] == slot)
+                continue;
+            if (!(*use)->isStore() || ops[0] != slot || ops[1] == slot || stored)
+                return UNKNOWN;
+            stored = ops[1];
+        }
+        SymbolEntry* param_se = stored ? stored->getEntry() : nullptr;
+        if (param_se && param_se->isVariable() && ((IdentifierSymbolEntry*)param_se)->isParam())
+        {
+            base = slot;
+            param = ((IdentifierSymbolEntry*)param_se)->getParamNo();
+            return PARAM;
+        }
+    }
+    return UNKNOWN;
+}
+
+// recompute the summary of a function, whether it grew.
+bool CallGraph::summarize(Function* func)
+{
+    Summary s;
+    // note an access at addr, in s itself or in the summary of the caller.
+    auto access = [&s](Operand* addr, bool write) {
+        Operand* base;
+        int param;
+        switch (root(addr, base, param))
+        {
+            case GLOBAL:
+                (write ? s.writes : s.reads).insert(base);
+                break;
+            case PARAM:
+                (write ? s.paramWrites : s.paramReads).insert(param);
+                break;
+            case UNKNOWN:
+                s.unknown = true;
+                break;
+        }
+    };
+    for (auto bb : func->getBlockList())
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+        {
+            if (inst->isLoad() || inst->isVLoad())
+                access(inst->getOperands()[1], false);
+            else if (inst->isStore() || inst->isVStore())
+                access(inst->getOperands()[0], true);
+            else if (inst->isCall())
+            {
+                Summary& c = getSummary(inst);
+                s.reads.insert(c.reads.begin(), c.reads.end());
+                s.writes.insert(c.writes.begin(), c.writes.end());
+                s.io |= c.io;
+                s.unknown |= c.unknown;
+                std::vector<Operand*>& operands = inst->getOperands();
+                for (size_t i = 1; i < operands.size(); i++)
+                {
+                    if (!operands[i]->getType()->isPtr())
+                        continue;
+                    if (c.paramReads.count(i - 1))
+                        access(operands[i], false);
+                    if (c.paramWrites.count(i - 1))
+                        access(operands[i], true);
+                }
+            }
+        }
+    Summary& old = summaries[func];
+    bool change = s.reads != old.reads || s.writes != old.writes || s.paramReads != old.paramReads
+        || s.paramWrites != old.paramWrites || s.io != old.io || s.unknown != old.unknown;
+    old = s;
+    return change;
+}
+
+bool CallGraph::mayAccess(Instruction* call, Operand* addr, bool reads)
+{
+    Summary& s = getSummary(call);
+    if (s.unknown)
+        return true;
+    Operand* base;
+    int param;
+    int kind = root(addr, base, param);
+    if (kind == UNKNOWN)
+        return !s.writes.empty() || !s.paramWrites.empty() || (reads && (!s.reads.empty() || !s.paramReads.empty()));
+    // a global directly, or an array parameter that may be a global.
+    if (kind == GLOBAL && (s.writes.count(base) || (reads && s.reads.count(base))))
+        return true;
+    if (kind == PARAM && (!s.writes.empty() || (reads && !s.reads.empty())))
+        return true;
+    // through an array passed to the call, parameters may point into each other or into a global.
+    std::vector<Operand*>& operands = call->getOperands();
+    for (size_t i = 1; i < operands.size(); i++)
+    {
+        if (!operands[i]->getType()->isPtr())
+            continue;
+        if (!s.paramWrites.count(i - 1) && !(reads && s.paramReads.count(i - 1)))
+            continue;
+        Operand* argBase;
+        int argParam;
+        int argKind = root(operands[i], argBase, argParam);
+        if (argBase == base || argKind == UNKNOWN || (argKind == PARAM && kind != LOCAL) || (argKind == GLOBAL && kind == PARAM))
+            return true;
+    }
+    return false;
+}
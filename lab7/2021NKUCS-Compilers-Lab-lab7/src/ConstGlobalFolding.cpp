@@ -0,0 +1,97 @@
+#include "ConstGlobalFolding.h"
+#include <map>
+#include <set>
+#include <string>
+#include "Instruction.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* A global is constant when it is declared const, or when every use of its
+ * address, in any function, is a load or an element address that is only
+ * loaded from in turn. A load from such a global at an offset known at
+ * compile time, through element addresses with constant indices only, is
+ * its initial value. The element addresses left without users go too. */
+
+ConstGlobalFolding::ConstGlobalFolding(Unit* unit)
+{
+    this->unit = unit;
+}
+
+void ConstGlobalFolding::pass()
+{
+    std::map<std::string, std::set<Operand*>> addrs;
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        for (auto bb : (*it)->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+                for (auto use : inst->getUse())
+                {
+                    SymbolEntry* se = use->getEntry();
+                    if (se->isVariable() && ((IdentifierSymbolEntry*)se)->isGlobal())
+                        addrs[se->toStr()].insert(use);
+                }
+    for (auto s : unit->getGlobals())
+    {
+        IdentifierSymbolEntry* se = (IdentifierSymbolEntry*)s;
+        bool constant = true;
+        for (auto addr : addrs[se->toStr()])
+            if (!readOnly(addr))
+                constant = false;
+        if (!constant && !se->getConst())
+            continue;
+        for (auto addr : addrs[se->toStr()])
+            fold(addr, se, 0, true);
+    }
+}
+
+// whether addr is only loaded from, directly or through element addresses.
+bool ConstGlobalFolding::readOnly(Operand* addr)
+{
+    for (auto use = addr->use_begin(); use != addr->use_end(); use++)
+    {
+        Instruction* inst = *use;
+        if ((inst->isLoad() || inst->isVLoad()) && inst->getOperands()[1] == addr)
+            continue;
+        if (inst->isGep() && inst->getOperands()[1] == addr && readOnly(inst->getDef()))
+            continue;
+        return false;
+    }
+    return true;
+}
+
+// fold the loads from addr, offset bytes into se, when known is set.
+void ConstGlobalFolding::fold(Operand* addr, IdentifierSymbolEntry* se, int offset, bool known)
+{
+    std::vector<Instruction*> users(addr->use_begin(), addr->use_end());
+    for (auto inst : users)
+    {
+        std::vector<Operand*>& ops = inst->getOperands();
+        if (inst->isLoad() && ops[1] == addr && known)
+        {
+            int value;
+            if (!se->getType()->isArray())
+                value = se->getValue();
+            else if (offset >= 0 && offset % 4 == 0 && offset < se->getType()->getSize() / 8)
+                value = se->getArrayValue(offset / 4);
+            else
+                continue;
+            Operand* def = inst->getDef();
+            Operand* rep = Operand::constant(value);
+            std::vector<Instruction*> loads(def->use_begin(), def->use_end());
+            for (auto load : loads)
+                load->replaceUse(def, rep);
+            inst->getParent()->erase(inst);
+        }
+        else if (inst->isGep() && ops[1] == addr)
+        {
+            Type* type = ((PointerType*)addr->getType())->getType();
+            if (!type->isArray())
+                continue;
+            int size = ((ArrayType*)type)->getElementType()->getSize() / 8;
+            SymbolEntry* index = ops[2]->getEntry();
+            bool constant = known && index->isConstant();
+            fold(inst->getDef(), se, constant ? offset + ((ConstantSymbolEntry*)index)->getValue() * size : 0, constant);
+            if (inst->getDef()->usersNum() == 0)
+                inst->getParent()->erase(inst);
+        }
+    }
+}
@@ -0,0 +1,227 @@
+#include "ConstantPropagation.h"
+#include <climits>
+#include "Instruction.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* Every temporary, and every int slot whose address is only ever loaded
+ * from and stored to, starts out with nothing known about it. Blocks are
+ * visited once the branches before them can reach them, and an operand
+ * only ever goes down from nothing known, to one value, to any value, so
+ * the visiting stops. A slot holds the meet of what the reachable stores
+ * put in it, the slot of a local never written after its initialization
+ * holds that value. What ends up a single value is replaced by it, the
+ * branches on such a value jump straight to their target, and the blocks
+ * left unreached go. */
+
+ConstantPropagation::ConstantPropagation(Unit* unit)
+{
+    this->unit = unit;
+}
+
+void ConstantPropagation::pass()
+{
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        propagate(*it);
+}
+
+ConstantPropagation::Value ConstantPropagation::get(Operand* op)
+{
+    Value value;
+    SymbolEntry* se = op->getEntry();
+    if (se->isConstant())
+    {
+        value.kind = Value::CONST;
+        value.value = ((ConstantSymbolEntry*)se)->getValue();
+    }
+    else if (se->isTemporary() && values.count(op))
+        value = values[op];
+    else if (!se->isTemporary())
+        value.kind = Value::BOTTOM;
+    return value;
+}
+
+// meet the value of op with value, and visit its users again when that changes it.
+void ConstantPropagation::lower(Operand* op, Value value)
+{
+    Value& old = values[op];
+    if (value.kind == Value::TOP || old.kind == Value::BOTTOM)
+        return;
+    if (old.kind == Value::CONST && value.kind == Value::CONST && old.value == value.value)
+        return;
+    if (old.kind == Value::TOP)
+        old = value;
+    else
+        old.kind = Value::BOTTOM;
+    for (auto use = op->use_begin(); use != op->use_end(); use++)
+        insts.push_back(*use);
+}
+
+void ConstantPropagation::reach(BasicBlock* bb)
+{
+    if (executable.insert(bb).second)
+        blocks.push_back(bb);
+}
+
+// the value inst defines, from what is known of its operands.
+ConstantPropagation::Value ConstantPropagation::eval(Instruction* inst)
+{
+    Value result;
+    std::vector<Operand*>& ops = inst->getOperands();
+    if (inst->isLoad())
+    {
+        if (slots.count(ops[1]))
+            return values[ops[1]];
+        result.kind = Value::BOTTOM;
+        return result;
+    }
+    if (!inst->isBinary() && !inst->isCmp() && !inst->isZext() && !inst->isXor())
+    {
+        result.kind = Value::BOTTOM;
+        return result;
+    }
+    Value a = get(ops[1]);
+    Value b = inst->isBinary() || inst->isCmp() ? get(ops[2]) : a;
+    if (a.kind == Value::BOTTOM || b.kind == Value::BOTTOM)
+    {
+        result.kind = Value::BOTTOM;
+        return result;
+    }
+    if (a.kind == Value::TOP || b.kind == Value::TOP)
+        return result;
+    result.kind = Value::CONST;
+    int x = a.value, y = b.value;
+    if (inst->isZext())
+        result.value = x;
+    else if (inst->isXor())
+        result.value = !x;
+    else if (inst->isCmp())
+        switch (inst->getOpcode())
+        {
+            case CmpInstruction::E: result.value = x == y; break;
+            case CmpInstruction::NE: result.value = x != y; break;
+            case CmpInstruction::L: result.value = x < y; break;
+            case CmpInstruction::LE: result.value = x <= y; break;
+            case CmpInstruction::G: result.value = x > y; break;
+            case CmpInstruction::GE: result.value = x >= y; break;
+        }
+    else
+        switch (inst->getOpcode())
+        {
+            case BinaryInstruction::ADD: result.value = (unsigned)x + (unsigned)y; break;
+            case BinaryInstruction::SUB: result.value = (unsigned)x - (unsigned)y; break;
+            case BinaryInstruction::MUL: result.value = (unsigned)x * (unsigned)y; break;
+            case BinaryInstruction::AND: result.value = x & y; break;
+            case BinaryInstruction::OR: result.value = x | y; break;
+            default:
+                // left to the program, as it would fault at run time.
+                if (y == 0 || (y == -1 && x == INT_MIN))
+                    result.kind = Value::BOTTOM;
+                else
+                    result.value = inst->getOpcode() == BinaryInstruction::DIV ? x / y : x % y;
+        }
+    return result;
+}
+
+void ConstantPropagation::visit(Instruction* inst)
+{
+    std::vector<Operand*>& ops = inst->getOperands();
+    if (inst->isUncond())
+        reach(((UncondBrInstruction*)inst)->getBranch());
+    else if (inst->isCond())
+    {
+        CondBrInstruction* br = (CondBrInstruction*)inst;
+        Value cond = get(ops[0]);
+        if (cond.kind != Value::CONST || cond.value)
+            reach(br->getTrueBranch());
+        if (cond.kind != Value::CONST || !cond.value)
+            reach(br->getFalseBranch());
+    }
+    else if (inst->isStore() && slots.count(ops[0]))
+    {
+        lower(ops[0], get(ops[1]));
+        return;
+    }
+    else if (inst->getDef() && !inst->isAlloc())
+        lower(inst->getDef(), eval(inst));
+}
+
+void ConstantPropagation::propagate(Function* func)
+{
+    values.clear();
+    executable.clear();
+    slots = func->getSlots();
+    reach(func->getEntry());
+    while (!blocks.empty() || !insts.empty())
+    {
+        if (!blocks.empty())
+        {
+            BasicBlock* bb = blocks.back();
+            blocks.pop_back();
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+                visit(inst);
+            continue;
+        }
+        Instruction* inst = insts.back();
+        insts.pop_back();
+        if (executable.count(inst->getParent()))
+            visit(inst);
+    }
+    rewrite(func);
+}
+
+void ConstantPropagation::rewrite(Function* func)
+{
+    for (auto bb : func->getBlockList())
+    {
+        if (!executable.count(bb))
+            continue;
+        for (auto inst = bb->begin(); inst != bb->end();)
+        {
+            Instruction* next = inst->getNext();
+            Operand* def = inst->getDef();
+            if (inst->isCond() && get(inst->getOperands()[0]).kind == Value::CONST)
+            {
+                CondBrInstruction* br = (CondBrInstruction*)inst;
+                bool cond = get(inst->getOperands()[0]).value;
+                BasicBlock* taken = cond ? br->getTrueBranch() : br->getFalseBranch();
+                BasicBlock* other = cond ? br->getFalseBranch() : br->getTrueBranch();
+                bb->insertBefore(new UncondBrInstruction(taken), br);
+                br->getParent()->erase(br);
+                if (other != taken)
+                {
+                    bb->removeSucc(other);
+                    other->removePred(bb);
+                }
+            }
+            else if (def && !inst->isAlloc() && !inst->isCall() && get(def).kind == Value::CONST)
+            {
+                Operand* rep = Operand::constant(get(def).value);
+                std::vector<Instruction*> users(def->use_begin(), def->use_end());
+                for (auto user : users)
+                    user->replaceUse(def, rep);
+                inst->getParent()->erase(inst);
+            }
+            inst = next;
+        }
+    }
+
+    func->removeUnreachable();
+
+    // a slot holding one value all along is no longer read, its stores and itself go.
+    for (auto addr : slots)
+    {
+        if (values[addr].kind != Value::CONST)
+            continue;
+        bool loaded = false;
+        for (auto use = addr->use_begin(); use != addr->use_end(); use++)
+            if ((*use)->isLoad())
+                loaded = true;
+        if (loaded)
+            continue;
+        std::vector<Instruction*> users(addr->use_begin(), addr->use_end());
+        for (auto user : users)
+            user->getParent()->erase(user);
+        addr->getDef()->getParent()->erase(addr->getDef());
+    }
+}
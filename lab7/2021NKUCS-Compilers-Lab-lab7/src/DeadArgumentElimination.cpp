@@ -0,0 +1,148 @@
+#include "DeadArgumentElimination.h"
+#include "Instruction.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* A parameter is dead when nothing reads it, or when it is only stored to a
+ * stack slot that is never loaded. A result is dead when every call drops
+ * it. A function other than main loses its dead parameters, together with
+ * their slots, and returns void when its result is dead, and every call is
+ * rebuilt to match. The function gets a type of its own, and the parameters
+ * it keeps are numbered again through symbol entries of their own, since a
+ * specialized copy shares both with the function it was made from. */
+
+DeadArgumentElimination::DeadArgumentElimination(Unit* unit)
+{
+    this->unit = unit;
+}
+
+void DeadArgumentElimination::pass()
+{
+    std::map<SymbolEntry*, Function*> functions;
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        functions[(*it)->getSymPtr()] = *it;
+    calls.clear();
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        for (auto bb : (*it)->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+                if (inst->isCall() && functions.count(((CallInstruction*)inst)->getFuncSe()))
+                    calls[functions[((CallInstruction*)inst)->getFuncSe()]].push_back(inst);
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        if ((*it)->getSymPtr()->toStr() != "@main")
+            pass(*it);
+}
+
+// the users of a parameter in func, a specialized copy reads the same operand.
+std::vector<Instruction*> DeadArgumentElimination::users(Function* func, Operand* param)
+{
+    std::vector<Instruction*> users;
+    if (param)
+        for (auto use = param->use_begin(); use != param->use_end(); use++)
+            if ((*use)->getParent()->getParent() == func)
+                users.push_back(*use);
+    return users;
+}
+
+// whether param is never read, stores are the stores of it to slots never loaded.
+bool DeadArgumentElimination::dead(Function* func, Operand* param, std::vector<Instruction*>& stores)
+{
+    stores.clear();
+    for (auto store : users(func, param))
+    {
+        if (!store->isStore() || store->getOperands()[1] != param)
+            return false;
+        Operand* slot = store->getOperands()[0];
+        if (!slot->getDef() || !slot->getDef()->isAlloc())
+            return false;
+        for (auto user = slot->use_begin(); user != slot->use_end(); user++)
+            if (!(*user)->isStore() || (*user)->getOperands()[0] != slot)
+                return false;
+        stores.push_back(store);
+    }
+    return true;
+}
+
+void DeadArgumentElimination::pass(Function* func)
+{
+    FunctionType* type = (FunctionType*)func->getSymPtr()->getType();
+    std::vector<Type*> paramsType = type->getParamsType();
+    std::vector<SymbolEntry*> paramsSe = type->getParamsSe();
+    std::vector<Operand*> params(paramsSe.size(), nullptr);
+    for (auto bb : func->getBlockList())
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            for (auto use : inst->getUse())
+            {
+                SymbolEntry* se = use->getEntry();
+                if (se->isVariable() && ((IdentifierSymbolEntry*)se)->isParam())
+                    params[((IdentifierSymbolEntry*)se)->getParamNo()] = use;
+            }
+    std::vector<bool> live(params.size());
+    std::vector<Instruction*> stores;
+    bool change = false;
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        live[i] = !dead(func, params[i], stores);
+        change |= !live[i];
+    }
+    bool result = !type->getRetType()->isVoid();
+    if (result)
+    {
+        bool used = false;
+        for (auto call : calls[func])
+            if (call->getDef() && call->getDef()->usersNum() > 0)
+                used = true;
+        result = used;
+        change |= !result;
+    }
+    if (!change)
+        return;
+
+    std::vector<Type*> keptTypes;
+    std::vector<SymbolEntry*> keptSe;
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        if (!live[i])
+        {
+            dead(func, params[i], stores);
+            for (auto store : stores)
+            {
+                Instruction* alloca = store->getOperands()[0]->getDef();
+                store->getParent()->erase(store);
+                if (alloca->getDef()->usersNum() == 0)
+                    alloca->getParent()->erase(alloca);
+            }
+            continue;
+        }
+        IdentifierSymbolEntry* se = new IdentifierSymbolEntry(*(IdentifierSymbolEntry*)paramsSe[i]);
+        se->setParamNo(keptSe.size());
+        Operand* rep = new Operand(se);
+        for (auto user : users(func, params[i]))
+            user->replaceUse(params[i], rep);
+        keptTypes.push_back(paramsType[i]);
+        keptSe.push_back(se);
+    }
+    func->getSymPtr()->setType(new FunctionType(result ? type->getRetType() : TypeSystem::voidType, keptTypes, keptSe));
+
+    if (!result)
+        for (auto bb : func->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+                if (inst->isRet() && !inst->getOperands().empty())
+                {
+                    Instruction* ret = new RetInstruction(nullptr);
+                    bb->insertBefore(ret, inst);
+                    inst->getParent()->erase(inst);
+                    inst = ret;
+                }
+    for (auto call : calls[func])
+    {
+        std::vector<Operand*> args;
+        for (size_t i = 0; i < live.size(); i++)
+            if (live[i])
+                args.push_back(call->getOperands()[i + 1]);
+        Operand* dst = result ? call->getDef() : nullptr;
+        BasicBlock* bb = call->getParent();
+        Instruction* rep = new CallInstruction(dst, ((CallInstruction*)call)->getFuncSe(), args);
+        bb->insertBefore(rep, call);
+        call->getParent()->erase(call);
+    }
+}
@@ -0,0 +1,27 @@
+#include "DeadCallElimination.h"
+#include "Instruction.h"
+#include "Unit.h"
+
+DeadCallElimination::DeadCallElimination(Unit* unit) : callGraph(unit)
+{
+    this->unit = unit;
+}
+
+void DeadCallElimination::pass()
+{
+    callGraph.pass();
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        for (auto bb : (*it)->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end();)
+            {
+                Instruction* next = inst->getNext();
+                Operand* def = inst->isCall() ? inst->getDef() : nullptr;
+                if (inst->isCall() && (!def || def->usersNum() == 0) && callGraph.isPure(inst))
+                {
+                    bb->remove(inst);
+                    for (auto use : inst->getUse())
+                        use->removeUse(inst);
+                }
+                inst = next;
+            }
+}
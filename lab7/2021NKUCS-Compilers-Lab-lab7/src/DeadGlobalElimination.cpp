@@ -0,0 +1,119 @@
+#include "DeadGlobalElimination.h"
+#include <map>
+#include <set>
+#include "Instruction.h"
+#include "MachineCode.h"
+#include "Unit.h"
+
+extern MachineUnit mUnit;
+
+/* Functions are kept when a chain of calls leads to them from main, which
+ * after inlining and specialization leaves out many of them. A global is
+ * kept when a kept function reads it. One that is only ever stored to,
+ * directly or through element addresses, loses those stores too. Whatever
+ * goes is dropped from the machine unit as well, so its data and its
+ * address pool entries are never printed. */
+
+DeadGlobalElimination::DeadGlobalElimination(Unit* unit)
+{
+    this->unit = unit;
+}
+
+void DeadGlobalElimination::pass()
+{
+    removeFunctions();
+    removeGlobals();
+}
+
+void DeadGlobalElimination::removeFunctions()
+{
+    std::map<SymbolEntry*, Function*> functions;
+    Function* main = nullptr;
+    for (auto it = unit->begin(); it != unit->end(); it++)
+    {
+        functions[(*it)->getSymPtr()] = *it;
+        if ((*it)->getSymPtr()->toStr() == "@main")
+            main = *it;
+    }
+    if (!main)
+        return;
+    std::set<Function*> reached = {main};
+    std::vector<Function*> stack = {main};
+    while (!stack.empty())
+    {
+        Function* func = stack.back();
+        stack.pop_back();
+        for (auto bb : func->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            {
+                if (!inst->isCall() || !functions.count(((CallInstruction*)inst)->getFuncSe()))
+                    continue;
+                Function* callee = functions[((CallInstruction*)inst)->getFuncSe()];
+                if (reached.insert(callee).second)
+                    stack.push_back(callee);
+            }
+    }
+    std::vector<Function*> dead;
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        if (!reached.count(*it))
+            dead.push_back(*it);
+    // what a removed function reads no longer counts as a use.
+    for (auto func : dead)
+    {
+        for (auto bb : func->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+                for (auto use : inst->getUse())
+                    use->removeUse(inst);
+        unit->removeFunc(func);
+    }
+}
+
+// whether addr is only stored to, writes collects the stores and the addresses leading to them.
+bool DeadGlobalElimination::writeOnly(Operand* addr, std::vector<Instruction*>& writes)
+{
+    for (auto use = addr->use_begin(); use != addr->use_end(); use++)
+    {
+        Instruction* inst = *use;
+        std::vector<Operand*>& ops = inst->getOperands();
+        if ((inst->isStore() || inst->isVStore()) && ops[0] == addr && ops[1] != addr)
+            writes.push_back(inst);
+        else if (inst->isGep() && ops[1] == addr && writeOnly(ops[0], writes))
+            writes.push_back(inst);
+        else
+            return false;
+    }
+    return true;
+}
+
+void DeadGlobalElimination::removeGlobals()
+{
+    std::map<std::string, std::set<Operand*>> addrs;
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        for (auto bb : (*it)->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+                for (auto use : inst->getUse())
+                {
+                    SymbolEntry* se = use->getEntry();
+                    if (se->isVariable() && ((IdentifierSymbolEntry*)se)->isGlobal())
+                        addrs[se->toStr()].insert(use);
+                }
+    std::vector<SymbolEntry*> globals = unit->getGlobals();
+    for (auto se : globals)
+    {
+        std::vector<Instruction*> writes;
+        bool dead = true;
+        for (auto addr : addrs[se->toStr()])
+            if (!writeOnly(addr, writes))
+                dead = false;
+        if (!dead)
+            continue;
+        for (auto inst : writes)
+        {
+            inst->getParent()->remove(inst);
+            for (auto use : inst->getUse())
+                use->removeUse(inst);
+        }
+        unit->removeGlobal(se);
+        mUnit.removeGlobal(se);
+    }
+}
@@ -0,0 +1,190 @@
+#include "DeadStoreElimination.h"
+#include <map>
+#include <sstream>
+#include "AliasAnalysis.h"
+#include "Instruction.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* A local whose address goes nowhere but into its own loads, stores,
+ * element addresses and calls that only fill it, like the memset clearing an
+ * initialized array, can only be read by those loads. With none, every store
+ * and fill goes, the element addresses and the alloca with them. For an int
+ * slot the stores are weighed one by one: a backward pass finds where the
+ * slot may still be loaded, and a store where it can't be, because every
+ * path stores it again or returns first, goes. Within a block a store to an
+ * address stored to again before anything may read it goes too, for any
+ * address the two stores surely share. */
+
+DeadStoreElimination::DeadStoreElimination(Unit* unit) : callGraph(unit)
+{
+    this->unit = unit;
+}
+
+void DeadStoreElimination::pass()
+{
+    callGraph.pass();
+    for (auto it = unit->begin(); it != unit->end(); it++)
+    {
+        removeUnread(*it);
+        removeOverwritten(*it);
+        for (auto bb : (*it)->getBlockList())
+            removeLocalOverwritten(bb);
+    }
+}
+
+// whether the call does nothing but write through addr, as memset does.
+bool DeadStoreElimination::fills(Instruction* call, Operand* addr)
+{
+    CallGraph::Summary& s = callGraph.getSummary(call);
+    std::vector<Operand*>& ops = call->getOperands();
+    if (s.io || s.unknown || !s.writes.empty() || (ops[0] && ops[0]->usersNum()))
+        return false;
+    for (size_t i = 1; i < ops.size(); i++)
+        if (ops[i] == addr ? s.paramReads.count(i - 1) : s.paramWrites.count(i - 1))
+            return false;
+    return true;
+}
+
+// whether addr is used other than to load, store or index, read is set by any load and accesses collects them all.
+bool DeadStoreElimination::escapes(Operand* addr, bool& read, std::vector<Instruction*>& accesses)
+{
+    for (auto use = addr->use_begin(); use != addr->use_end(); use++)
+    {
+        Instruction* inst = *use;
+        std::vector<Operand*>& ops = inst->getOperands();
+        if ((inst->isLoad() || inst->isVLoad()) && ops[1] == addr)
+            read = true;
+        else if ((inst->isStore() || inst->isVStore()) && ops[0] == addr && ops[1] != addr)
+            ;
+        else if (inst->isCall() && fills(inst, addr))
+            ;
+        else if (inst->isGep() && ops[1] == addr)
+        {
+            if (escapes(ops[0], read, accesses))
+                return true;
+        }
+        else
+            return true;
+        accesses.push_back(inst);
+    }
+    return false;
+}
+
+void DeadStoreElimination::removeUnread(Function* func)
+{
+    std::vector<Instruction*> allocas;
+    for (auto inst = func->getEntry()->begin(); inst != func->getEntry()->end(); inst = inst->getNext())
+        if (inst->isAlloc())
+            allocas.push_back(inst);
+    for (auto alloca : allocas)
+    {
+        bool read = false;
+        std::vector<Instruction*> accesses;
+        if (escapes(alloca->getDef(), read, accesses) || read)
+            continue;
+        std::set<Instruction*> erased;
+        for (auto inst : accesses)
+            if (erased.insert(inst).second)
+                inst->getParent()->erase(inst);
+        alloca->getParent()->erase(alloca);
+    }
+}
+
+void DeadStoreElimination::removeOverwritten(Function* func)
+{
+    std::set<Operand*> slots = func->getSlots();
+    if (slots.empty())
+        return;
+    // the slots that may be loaded later, at the start of every block.
+    std::map<BasicBlock*, std::set<Operand*>> in;
+    std::vector<BasicBlock*>& blocks = func->getBlockList();
+    bool change = true;
+    while (change)
+    {
+        change = false;
+        for (auto it = blocks.rbegin(); it != blocks.rend(); it++)
+        {
+            BasicBlock* bb = *it;
+            std::set<Operand*> live;
+            for (auto succ = bb->succ_begin(); succ != bb->succ_end(); succ++)
+                live.insert(in[*succ].begin(), in[*succ].end());
+            for (auto inst = bb->rbegin(); inst != bb->rend(); inst = inst->getPrev())
+            {
+                std::vector<Operand*>& ops = inst->getOperands();
+                if (inst->isStore() && slots.count(ops[0]))
+                    live.erase(ops[0]);
+                else if (inst->isLoad() && slots.count(ops[1]))
+                    live.insert(ops[1]);
+            }
+            if (live != in[bb])
+            {
+                in[bb] = live;
+                change = true;
+            }
+        }
+    }
+    for (auto bb : blocks)
+    {
+        std::set<Operand*> live;
+        for (auto succ = bb->succ_begin(); succ != bb->succ_end(); succ++)
+            live.insert(in[*succ].begin(), in[*succ].end());
+        for (auto inst = bb->rbegin(); inst != bb->rend();)
+        {
+            Instruction* prev = inst->getPrev();
+            std::vector<Operand*>& ops = inst->getOperands();
+            if (inst->isStore() && slots.count(ops[0]))
+            {
+                if (!live.count(ops[0]))
+                    inst->getParent()->erase(inst);
+                live.erase(ops[0]);
+            }
+            else if (inst->isLoad() && slots.count(ops[1]))
+                live.insert(ops[1]);
+            inst = prev;
+        }
+    }
+}
+
+// the same string for addresses surely the same.
+std::string DeadStoreElimination::key(Operand* addr)
+{
+    std::ostringstream buffer;
+    AliasAnalysis::Location loc = AliasAnalysis::locate(addr);
+    if (loc.kind != AliasAnalysis::UNKNOWN && loc.known)
+        buffer << loc.kind << " " << loc.base << "+" << loc.offset;
+    else
+        buffer << addr;
+    return buffer.str();
+}
+
+void DeadStoreElimination::removeLocalOverwritten(BasicBlock* bb)
+{
+    // stores not read since, by the address they write.
+    std::map<std::string, Instruction*> pending;
+    for (auto inst = bb->begin(); inst != bb->end();)
+    {
+        Instruction* next = inst->getNext();
+        std::vector<Operand*>& ops = inst->getOperands();
+        if (inst->isStore())
+        {
+            std::string k = key(ops[0]);
+            if (pending.count(k))
+                pending[k]->getParent()->erase(pending[k]);
+            pending[k] = inst;
+        }
+        else if (inst->isLoad() || inst->isVLoad() || inst->isCall() || inst->isRet() || inst->isVStore())
+        {
+            std::vector<std::string> read;
+            for (auto& it : pending)
+            {
+                Operand* addr = it.second->getOperands()[0];
+                if (inst->isRet() || inst->isVLoad() || inst->isVStore() || (inst->isLoad() && AliasAnalysis::mayAlias(addr, ops[1])) || (inst->isCall() && callGraph.mayAccess(inst, addr, true)))
+                    read.push_back(it.first);
+            }
+            for (auto& k : read)
+                pending.erase(k);
+        }
+        inst = next;
+    }
+}
@@ -27,6 +27,60 @@ void Function::remove(BasicBlock *bb)
     block_list.erase(std::find(block_list.begin(), block_list.end(), bb));
 }
 
+bool Function::removeUnreachable()
+{
+    std::set<BasicBlock*> reached = {entry};
+    std::vector<BasicBlock*> stack = {entry};
+    while (!stack.empty())
+    {
+        BasicBlock* bb = stack.back();
+        stack.pop_back();
+        for (auto succ = bb->succ_begin(); succ != bb->succ_end(); succ++)
+            if (reached.insert(*succ).second)
+                stack.push_back(*succ);
+    }
+    std::vector<BasicBlock*> list = block_list;
+    bool change = false;
+    for (auto bb : list)
+    {
+        if (reached.count(bb))
+            continue;
+        for (auto inst = bb->begin(); inst != bb->end();)
+        {
+            Instruction* next = inst->getNext();
+            bb->erase(inst);
+            inst = next;
+        }
+        std::vector<BasicBlock*> succs(bb->succ_begin(), bb->succ_end());
+        for (auto succ : succs)
+            succ->removePred(bb);
+        remove(bb);
+        change = true;
+    }
+    return change;
+}
+
+std::set<Operand*> Function::getSlots()
+{
+    std::set<Operand*> slots;
+    for (auto inst = entry->begin(); inst != entry->end(); inst = inst->getNext())
+    {
+        if (!inst->isAlloc() || !((PointerType*)inst->getDef()->getType())->getType()->isInt())
+            continue;
+        Operand* addr = inst->getDef();
+        bool direct = true;
+        for (auto use = addr->use_begin(); use != addr->use_end(); use++)
+        {
+            std::vector<Operand*>& ops = (*use)->getOperands();
+            if (!((*use)->isLoad() && ops[1] == addr) && !((*use)->isStore() && ops[0] == addr && ops[1] != addr))
+                direct = false;
+        }
+        if (direct)
+            slots.insert(addr);
+    }
+    return slots;
+}
+
 void Function::output() const {
     FunctionType* funcType = dynamic_cast<FunctionType*>(sym_ptr->getType());
     Type* retType = funcType->getRetType();
@@ -0,0 +1,219 @@
+#include "GlobalPromotion.h"
+#include <algorithm>
+#include <string>
+#include "Instruction.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* A global int only main reads or writes, and main is never called, turns
+ * into a stack slot of main that starts with the initial value, which
+ * spares loading its address from the pool on every access. Elsewhere a
+ * global int read or written in a loop whose calls never touch it is
+ * loaded into a slot in a new preheader, the loop works on the slot, and
+ * when the loop writes it the slot is stored back on every exit edge and
+ * before every return inside the loop.
+ * Loops are taken from the outermost in, so a global is kept in a slot over
+ * the widest loop that allows it. */
+
+GlobalPromotion::GlobalPromotion(Unit* unit) : callGraph(unit)
+{
+    this->unit = unit;
+}
+
+void GlobalPromotion::pass()
+{
+    callGraph.pass();
+    localize();
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        promote(*it);
+}
+
+// whether inst loads from or stores to addr, and does nothing else with it.
+bool GlobalPromotion::direct(Operand* addr, Instruction* inst)
+{
+    std::vector<Operand*>& ops = inst->getOperands();
+    return (inst->isLoad() && ops[1] == addr) || (inst->isStore() && ops[0] == addr && ops[1] != addr);
+}
+
+// a new int slot of func, stored init at the start of the entry.
+Operand* GlobalPromotion::slot(Operand* init)
+{
+    Operand* addr = Operand::temporary(new PointerType(TypeSystem::intType));
+    BasicBlock* entry = func->getEntry();
+    if (init)
+        entry->insertFront(new StoreInstruction(addr, init));
+    entry->insertFront(new AllocaInstruction(addr, new TemporarySymbolEntry(TypeSystem::intType, SymbolTable::getLabel())));
+    return addr;
+}
+
+// send the edges from -> to to mid instead.
+void GlobalPromotion::redirect(BasicBlock* from, BasicBlock* to, BasicBlock* mid)
+{
+    for (auto inst = from->begin(); inst != from->end(); inst = inst->getNext())
+        if (inst->isCond())
+        {
+            CondBrInstruction* br = (CondBrInstruction*)inst;
+            if (br->getTrueBranch() == to)
+                br->setTrueBranch(mid);
+            if (br->getFalseBranch() == to)
+                br->setFalseBranch(mid);
+        }
+        else if (inst->isUncond() && ((UncondBrInstruction*)inst)->getBranch() == to)
+            ((UncondBrInstruction*)inst)->setBranch(mid);
+    while (std::find(from->succ_begin(), from->succ_end(), to) != from->succ_end())
+    {
+        from->removeSucc(to);
+        to->removePred(from);
+        from->addSucc(mid);
+        mid->addPred(from);
+    }
+}
+
+// a new block on the edge from -> to, laid out right before to.
+BasicBlock* GlobalPromotion::split(BasicBlock* from, BasicBlock* to)
+{
+    BasicBlock* mid = new BasicBlock(func);
+    std::vector<BasicBlock*>& list = func->getBlockList();
+    list.pop_back();
+    list.insert(std::find(list.begin(), list.end(), to), mid);
+    redirect(from, to, mid);
+    new UncondBrInstruction(to, mid);
+    mid->addSucc(to);
+    to->addPred(mid);
+    return mid;
+}
+
+void GlobalPromotion::localize()
+{
+    Function* main = nullptr;
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        if ((*it)->getSymPtr()->toStr() == "@main")
+            main = *it;
+    if (!main)
+        return;
+    // the functions using every global, by name, and the operands standing for it.
+    std::map<std::string, std::set<Function*>> users;
+    std::map<std::string, std::set<Operand*>> addrs;
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        for (auto bb : (*it)->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            {
+                if (inst->isCall() && ((CallInstruction*)inst)->getFuncSe() == main->getSymPtr())
+                    return;
+                for (auto use : inst->getUse())
+                {
+                    SymbolEntry* se = use->getEntry();
+                    if (!se->isVariable() || !((IdentifierSymbolEntry*)se)->isGlobal())
+                        continue;
+                    users[se->toStr()].insert(*it);
+                    addrs[se->toStr()].insert(use);
+                }
+            }
+    func = main;
+    for (auto se : unit->getGlobals())
+    {
+        std::string name = se->toStr();
+        if (users[name].size() != 1 || !users[name].count(main))
+            continue;
+        bool ok = true;
+        for (auto addr : addrs[name])
+        {
+            if (!addr->isGlobalInt())
+                ok = false;
+            for (auto use = addr->use_begin(); use != addr->use_end(); use++)
+                if (!direct(addr, *use))
+                    ok = false;
+        }
+        if (!ok)
+            continue;
+        Operand* s = slot(Operand::constant(((IdentifierSymbolEntry*)se)->getValue()));
+        for (auto addr : addrs[name])
+        {
+            std::vector<Instruction*> uses(addr->use_begin(), addr->use_end());
+            for (auto use : uses)
+                use->replaceUse(addr, s);
+        }
+    }
+}
+
+void GlobalPromotion::promote(Function* func)
+{
+    this->func = func;
+    LoopAnalysis analysis;
+    analysis.pass(func);
+    std::vector<LoopAnalysis::Loop*>& loops = analysis.getLoops();
+    for (auto it = loops.rbegin(); it != loops.rend(); it++)
+    {
+        LoopAnalysis::Loop* loop = *it;
+        std::vector<Instruction*> calls;
+        std::set<Operand*> accessed, other;
+        for (auto bb : loop->blocks)
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            {
+                if (inst->isCall())
+                    calls.push_back(inst);
+                for (auto use : inst->getUse())
+                    if (use->isGlobalInt())
+                        (direct(use, inst) ? accessed : other).insert(use);
+            }
+        for (auto addr : accessed)
+        {
+            if (other.count(addr))
+                continue;
+            bool clobbered = false;
+            for (auto call : calls)
+                if (callGraph.mayAccess(call, addr, true))
+                    clobbered = true;
+            if (!clobbered)
+                promote(loop, addr);
+        }
+    }
+}
+
+void GlobalPromotion::promote(LoopAnalysis::Loop* loop, Operand* addr)
+{
+    BasicBlock* header = loop->header;
+    std::vector<BasicBlock*> outside;
+    for (auto pred = header->pred_begin(); pred != header->pred_end(); pred++)
+        if (!loop->blocks.count(*pred) && std::find(outside.begin(), outside.end(), *pred) == outside.end())
+            outside.push_back(*pred);
+    if (outside.empty())
+        return;
+    Operand* s = slot(nullptr);
+    BasicBlock* preheader = split(outside[0], header);
+    for (size_t i = 1; i < outside.size(); i++)
+        redirect(outside[i], header, preheader);
+    Operand* value = Operand::temporary(TypeSystem::intType);
+    preheader->insertBefore(new LoadInstruction(value, addr), preheader->rbegin());
+    preheader->insertBefore(new StoreInstruction(s, value), preheader->rbegin());
+
+    bool written = false;
+    std::vector<Instruction*> uses(addr->use_begin(), addr->use_end());
+    for (auto use : uses)
+        if (loop->blocks.count(use->getParent()))
+        {
+            written |= use->isStore();
+            use->replaceUse(addr, s);
+        }
+    if (!written)
+        return;
+    std::vector<std::pair<BasicBlock*, BasicBlock*>> exits;
+    for (auto bb : loop->blocks)
+        for (auto succ = bb->succ_begin(); succ != bb->succ_end(); succ++)
+            if (!loop->blocks.count(*succ) && std::find(exits.begin(), exits.end(), std::make_pair(bb, *succ)) == exits.end())
+                exits.push_back({bb, *succ});
+    // the slot goes back to the global on every exit edge and before every return in the loop.
+    std::vector<Instruction*> ends;
+    for (auto bb : loop->blocks)
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            if (inst->isRet())
+                ends.push_back(inst);
+    for (auto& exit : exits)
+        ends.push_back(split(exit.first, exit.second)->rbegin());
+    for (auto pos : ends)
+    {
+        Operand* result = Operand::temporary(TypeSystem::intType);
+        pos->getParent()->insertBefore(new LoadInstruction(result, s), pos);
+        pos->getParent()->insertBefore(new StoreInstruction(addr, result), pos);
+    }
+}
@@ -0,0 +1,157 @@
+#include "GlobalValueNumbering.h"
+#include <sstream>
+#include "AliasAnalysis.h"
+#include "Instruction.h"
+#include "Unit.h"
+
+/* The blocks are walked down the dominator tree with a table of the
+ * expressions computed so far, keyed by opcode and operands, so what a
+ * block finds is what its dominators computed. Arithmetic and element
+ * addresses always match, a compare only when its result is kept in a
+ * register rather than in the flags, a call when the callee reads no memory
+ * and writes nothing. A load matches an earlier one at the same address
+ * when no store or call in between may write there; the tree walk only
+ * keeps loads available into a block with a single predecessor, which can
+ * only be entered from the block before it. */
+
+GlobalValueNumbering::GlobalValueNumbering(Unit* unit) : callGraph(unit)
+{
+    this->unit = unit;
+}
+
+void GlobalValueNumbering::pass()
+{
+    callGraph.pass();
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        number(*it);
+}
+
+std::string GlobalValueNumbering::key(Operand* op)
+{
+    std::ostringstream buffer;
+    if (op->getEntry()->isConstant())
+        buffer << "#" << ((ConstantSymbolEntry*)op->getEntry())->getValue();
+    else
+        buffer << op;
+    return buffer.str();
+}
+
+// what identifies the value inst computes, empty when it can't be reused.
+std::string GlobalValueNumbering::key(Instruction* inst)
+{
+    std::vector<Operand*>& ops = inst->getOperands();
+    if (!inst->getDef() || inst->getDef()->getDef() != inst)
+        return "";
+    std::ostringstream buffer;
+    if (inst->isBinary() || (inst->isCmp() && inst->getOpcode() >= CmpInstruction::L))
+    {
+        std::string a = key(ops[1]), b = key(ops[2]);
+        unsigned op = inst->getOpcode();
+        bool commutative = inst->isBinary() ? op == BinaryInstruction::ADD || op == BinaryInstruction::MUL || op == BinaryInstruction::AND || op == BinaryInstruction::OR : false;
+        if (commutative && b < a)
+            std::swap(a, b);
+        buffer << (inst->isBinary() ? "binary " : "cmp ") << op << " " << a << " " << b;
+    }
+    else if (inst->isGep())
+    {
+        GepInstruction* gep = (GepInstruction*)inst;
+        // the address of a fixed element of a global or local is cheaper to compute again than to keep in a register.
+        if (gep->isFirst() && ops[2]->getEntry()->isConstant())
+            return "";
+        // the same address decays to pointers of different types.
+        buffer << "gep " << gep->isFirst() << gep->isParamFirst() << " " << ops[0]->getType()->toStr() << " " << key(ops[1]) << " " << key(ops[2]);
+    }
+    else if (inst->isLoad())
+        buffer << "load " << key(ops[1]);
+    else if (inst->isCall())
+    {
+        CallGraph::Summary& s = callGraph.getSummary(inst);
+        if (!s.pure() || !s.reads.empty() || !s.paramReads.empty())
+            return "";
+        buffer << "call " << ((CallInstruction*)inst)->getFuncSe();
+        for (size_t i = 1; i < ops.size(); i++)
+            buffer << " " << key(ops[i]);
+    }
+    return buffer.str();
+}
+
+// change the table, remembering how to change it back.
+void GlobalValueNumbering::set(const std::string& k, Operand* value)
+{
+    auto it = table.find(k);
+    undo.push_back({k, it == table.end() ? nullptr : it->second});
+    if (value)
+        table[k] = value;
+    else if (it != table.end())
+        table.erase(it);
+}
+
+// drop the loads inst may write over, all of them for nullptr.
+void GlobalValueNumbering::kill(Instruction* inst)
+{
+    std::vector<std::string> dead;
+    for (auto it = table.lower_bound("load "); it != table.end() && it->first.compare(0, 5, "load ") == 0; it++)
+    {
+        Operand* addr = it->second->getDef()->getOperands()[1];
+        if (!inst || (inst->isStore() && AliasAnalysis::mayAlias(addr, inst->getOperands()[0])) || inst->isVStore() || (inst->isCall() && callGraph.mayAccess(inst, addr)))
+            dead.push_back(it->first);
+    }
+    for (auto& k : dead)
+        set(k, nullptr);
+}
+
+void GlobalValueNumbering::visit(BasicBlock* bb)
+{
+    size_t mark = undo.size();
+    if (bb->getNumOfPred() != 1)
+        kill(nullptr);
+    for (auto inst = bb->begin(); inst != bb->end();)
+    {
+        Instruction* next = inst->getNext();
+        if (inst->isStore() || inst->isVStore() || inst->isCall())
+            kill(inst);
+        std::string k = key(inst);
+        if (k.empty())
+        {
+            inst = next;
+            continue;
+        }
+        Operand* def = inst->getDef();
+        auto it = table.find(k);
+        bool flags = false;
+        for (auto use = def->use_begin(); use != def->use_end(); use++)
+            if ((*use)->isCond() || (*use)->isXor())
+                flags = true;
+        if (it == table.end())
+            set(k, def);
+        else if (!(inst->isCmp() && flags))
+        {
+            std::vector<Instruction*> users(def->use_begin(), def->use_end());
+            for (auto user : users)
+                user->replaceUse(def, it->second);
+            inst->getParent()->erase(inst);
+        }
+        inst = next;
+    }
+    for (auto child : children[bb])
+        visit(child);
+    while (undo.size() > mark)
+    {
+        auto& last = undo.back();
+        if (last.second)
+            table[last.first] = last.second;
+        else
+            table.erase(last.first);
+        undo.pop_back();
+    }
+}
+
+void GlobalValueNumbering::number(Function* func)
+{
+    analysis.pass(func);
+    children.clear();
+    for (auto bb : analysis.getOrder())
+        if (analysis.idom(bb))
+            children[analysis.idom(bb)].push_back(bb);
+    visit(func->getEntry());
+}
@@ -0,0 +1,242 @@
+#include "Inliner.h"
+#include <algorithm>
+#include <set>
+#include "Instruction.h"
+#include "LoopAnalysis.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* A call is replaced by a copy of the callee's blocks, placed between the
+ * block of the call and a new block holding what followed the call. The
+ * parameters are the arguments of the call, every temporary gets a fresh
+ * copy, allocas move to the entry of the caller and a return becomes a
+ * branch to the new block. With one return the call result is the returned
+ * operand itself, with more it goes through a stack slot. Keeping the copy
+ * between the two halves of the call block keeps the registers live across
+ * the call live across the inlined body too. */
+
+Inliner::Inliner(Unit* unit)
+{
+    this->unit = unit;
+}
+
+void Inliner::pass()
+{
+    // callees are defined before their callers, so they are already inlined into themselves.
+    for (auto it = unit->begin(); it != unit->end(); it++)
+    {
+        Function* func = *it;
+        LoopAnalysis analysis;
+        analysis.pass(func);
+        std::vector<std::pair<Instruction*, bool>> calls;
+        for (auto bb : func->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+                if (inst->isCall())
+                    calls.push_back({inst, analysis.getLoop(bb) != nullptr});
+        int total = size(func);
+        for (auto& call : calls)
+        {
+            Function* f = callee(call.first);
+            if (!f || f == func || !inlinable(f))
+                continue;
+            int n = size(f);
+            if (n > (call.second ? maxLoopSize : maxSize) || total + n > maxCallerSize)
+                continue;
+            inlineCall(call.first, f);
+            total += n;
+        }
+    }
+}
+
+// the branch or return ending a block, anything after it is never reached.
+Instruction* Inliner::terminator(BasicBlock* bb)
+{
+    for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+        if (inst->isRet() || inst->isCond() || inst->isUncond())
+            return inst;
+    return nullptr;
+}
+
+// the blocks reachable from the entry, in the order of the function.
+std::vector<BasicBlock*> Inliner::reachable(Function* func)
+{
+    std::set<BasicBlock*> visited;
+    std::vector<BasicBlock*> stack = {func->getEntry()};
+    visited.insert(func->getEntry());
+    while (!stack.empty())
+    {
+        BasicBlock* bb = stack.back();
+        stack.pop_back();
+        Instruction* last = terminator(bb);
+        std::vector<BasicBlock*> succs;
+        if (last && last->isCond())
+            succs = {((CondBrInstruction*)last)->getTrueBranch(), ((CondBrInstruction*)last)->getFalseBranch()};
+        else if (last && last->isUncond())
+            succs = {((UncondBrInstruction*)last)->getBranch()};
+        for (auto succ : succs)
+            if (visited.insert(succ).second)
+                stack.push_back(succ);
+    }
+    std::vector<BasicBlock*> blocks;
+    for (auto bb : func->getBlockList())
+        if (visited.count(bb))
+            blocks.push_back(bb);
+    return blocks;
+}
+
+int Inliner::size(Function* func)
+{
+    int n = 0;
+    for (auto bb : reachable(func))
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            n++;
+    return n;
+}
+
+// every block ends in a branch or return, and the function never calls itself.
+bool Inliner::inlinable(Function* func)
+{
+    for (auto bb : reachable(func))
+    {
+        if (!terminator(bb))
+            return false;
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            if (inst->isCall() && callee(inst) == func)
+                return false;
+    }
+    return true;
+}
+
+// the function a call goes to, nullptr for the runtime library.
+Function* Inliner::callee(Instruction* call)
+{
+    SymbolEntry* se = ((CallInstruction*)call)->getFuncSe();
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        if ((*it)->getSymPtr() == se)
+            return *it;
+    return nullptr;
+}
+
+Operand* Inliner::remap(Operand* op, std::vector<Operand*>& args)
+{
+    if (operands.count(op))
+        return operands[op];
+    SymbolEntry* se = op->getEntry();
+    Operand* rep = op;
+    if (se->isTemporary())
+        rep = Operand::temporary(se->getType());
+    else if (se->isVariable() && ((IdentifierSymbolEntry*)se)->isParam())
+        rep = args[((IdentifierSymbolEntry*)se)->getParamNo()];
+    operands[op] = rep;
+    return rep;
+}
+
+void Inliner::inlineCall(Instruction* call, Function* callee)
+{
+    BasicBlock* bb = call->getParent();
+    Function* func = bb->getParent();
+    std::vector<Operand*> args(call->getOperands().begin() + 1, call->getOperands().end());
+    Operand* result = call->getDef();
+    if (result && result->usersNum() == 0)
+        result = nullptr;
+    operands.clear();
+
+    std::vector<BasicBlock*> blocks = reachable(callee);
+    std::map<BasicBlock*, BasicBlock*> copies;
+    int rets = 0;
+    for (auto b : blocks)
+    {
+        copies[b] = new BasicBlock(func);
+        if (terminator(b)->isRet())
+            rets++;
+    }
+    BasicBlock* merge = new BasicBlock(func);
+    std::vector<BasicBlock*>& list = func->getBlockList();
+    list.erase(list.end() - blocks.size() - 1, list.end());
+    auto pos = std::find(list.begin(), list.end(), bb) + 1;
+    for (auto b : blocks)
+        pos = list.insert(pos, copies[b]) + 1;
+    list.insert(pos, merge);
+
+    // split the block of the call.
+    for (auto inst = call->getNext(); inst != bb->end();)
+    {
+        Instruction* next = inst->getNext();
+        bb->remove(inst);
+        merge->insertBack(inst);
+        inst = next;
+    }
+    std::vector<BasicBlock*> succs(bb->succ_begin(), bb->succ_end());
+    for (auto succ : succs)
+    {
+        bb->removeSucc(succ);
+        succ->removePred(bb);
+        merge->addSucc(succ);
+        succ->addPred(merge);
+    }
+    bb->remove(call);
+    for (auto arg : args)
+        arg->removeUse(call);
+    BasicBlock* entry = copies[callee->getEntry()];
+    new UncondBrInstruction(entry, bb);
+    bb->addSucc(entry);
+    entry->addPred(bb);
+
+    Operand* slot = nullptr;
+    if (result && rets > 1)
+    {
+        slot = Operand::temporary(new PointerType(TypeSystem::intType));
+        func->getEntry()->insertFront(new AllocaInstruction(slot, new TemporarySymbolEntry(TypeSystem::intType, SymbolTable::getLabel())));
+        merge->insertFront(new LoadInstruction(result, slot));
+    }
+    Operand* returned = nullptr;
+    auto link = [](BasicBlock* from, BasicBlock* to) {
+        from->addSucc(to);
+        to->addPred(from);
+    };
+    for (auto b : blocks)
+    {
+        BasicBlock* copy = copies[b];
+        Instruction* last = terminator(b);
+        for (auto inst = b->begin(); inst != last; inst = inst->getNext())
+        {
+            Instruction* c = inst->copy();
+            for (auto use : c->getUse())
+                c->replaceUse(use, remap(use, args));
+            if (c->getDef())
+                c->replaceDef(remap(c->getDef(), args));
+            if (c->isAlloc())
+                func->getEntry()->insertFront(c);
+            else
+                copy->insertBack(c);
+        }
+        if (last->isRet())
+        {
+            if (result && slot)
+                new StoreInstruction(slot, remap(last->getOperands()[0], args), copy);
+            else if (result)
+                returned = remap(last->getOperands()[0], args);
+            new UncondBrInstruction(merge, copy);
+            link(copy, merge);
+        }
+        else if (last->isCond())
+        {
+            CondBrInstruction* br = (CondBrInstruction*)last;
+            new CondBrInstruction(copies[br->getTrueBranch()], copies[br->getFalseBranch()], remap(br->getOperands()[0], args), copy);
+            link(copy, copies[br->getTrueBranch()]);
+            link(copy, copies[br->getFalseBranch()]);
+        }
+        else
+        {
+            BasicBlock* to = copies[((UncondBrInstruction*)last)->getBranch()];
+            new UncondBrInstruction(to, copy);
+            link(copy, to);
+        }
+    }
+    if (returned)
+    {
+        std::vector<Instruction*> users(result->use_begin(), result->use_end());
+        for (auto user : users)
+            user->replaceUse(result, returned);
+    }
+}
@@ -5,6 +5,7 @@
 #include "Function.h"
 #include "Type.h"
 extern FILE* yyout;
+extern int opt_level;
 
 Instruction::Instruction(unsigned instType, BasicBlock* insert_bb) 
 {
@@ -52,6 +53,39 @@ Instruction* Instruction::getPrev()
     return prev;
 }
 
+// replace the use of operand old with rep, keeping the use lists consistent.
+void Instruction::replaceUse(Operand* old, Operand* rep) 
+{
+    long unsigned int i = (getDef() || instType == CALL) ? 1 : 0;
+    for (; i < operands.size(); i++) 
+    {
+        if (operands[i] == old) 
+        {
+            old->removeUse(this);
+            operands[i] = rep;
+            rep->addUse(this);
+        }
+    }
+}
+
+void Instruction::replaceDef(Operand* rep) 
+{
+    operands[0] = rep;
+    rep->setDef(this);
+}
+
+Instruction* Instruction::copy() 
+{
+    Instruction* inst = clone();
+    inst->prev = inst->next = inst;
+    inst->parent = nullptr;
+    for (auto use : inst->getUse())
+    {
+        use->addUse(inst);
+    }
+    return inst;
+}
+
 BinaryInstruction::BinaryInstruction(unsigned opcode, Operand* dst, Operand* src1, Operand* src2, BasicBlock* insert_bb) : Instruction(BINARY, insert_bb) 
 {
     this->opcode = opcode;
@@ -227,7 +261,15 @@ void StoreInstruction::genMachineCode(AsmBuilder* builder)
     MachineOperand* dst = genMachineOperand(operands[0]);
     MachineOperand* src = genMachineOperand(operands[1]);
     auto t = dynamic_cast<IdentifierSymbolEntry*>(operands[0]->getEntry());
-    if (operands[1]->getEntry()->isConstant()) 
+    auto param = dynamic_cast<IdentifierSymbolEntry*>(operands[1]->getEntry());
+    if (param && param->isParam() && param->getParamNo() >= 4)
+    {
+        // passed on the stack by the caller.
+        MachineOperand* temp = genMachineVReg();
+        cur_block->InsertInst(new LoadMInstruction(cur_block, temp, genMachineReg(11), builder->getFunction()->paramOffset(param->getParamNo())));
+        src = new MachineOperand(*temp);
+    }
+    else if (operands[1]->getEntry()->isConstant()) 
     {
         MachineOperand* temp = genMachineVReg();
         cur_inst = new LoadMInstruction(cur_block, temp, src);
@@ -351,6 +393,8 @@ void RetInstruction::genMachineCode(AsmBuilder* builder)
      * 2. Restore callee saved registers and sp, fp
      * 3. Generate bx instruction */
     auto cur_block = builder->getBlock();
+    if (prev->isCall() && ((CallInstruction*)prev)->isSibling())
+        return;
     if (!operands.empty()) 
     {
         auto *temp = new MovMInstruction(cur_block, MovMInstruction::MOV, new MachineOperand(MachineOperand::REG, 0), genMachineOperand(operands[0]));
@@ -422,6 +466,19 @@ void GepInstruction::output() const {}
 
 GepInstruction::~GepInstruction() {}
 
+bool CallInstruction::isSibling()
+{
+    if (opt_level == 0 || !next->isRet() || operands.size() > 5)
+        return false;
+    if (!next->getOperands().empty() && next->getOperands()[0] != dst)
+        return false;
+    // an address may point into the frame we are about to free.
+    for (size_t i = 1; i < operands.size(); i++)
+        if (operands[i]->getType()->isPtr())
+            return false;
+    return true;
+}
+
 void CallInstruction::genMachineCode(AsmBuilder* builder) 
 {
     auto cur_block = builder->getBlock();
@@ -451,13 +508,22 @@ void CallInstruction::genMachineCode(AsmBuilder* builder)
         operand = genMachineOperand(operands[i]);
         if (operand->isImm()) 
         {
-            cur_inst = new LoadMInstruction(cur_block, genMachineVReg(), operand);
+            MachineOperand* temp = genMachineVReg();
+            cur_inst = new LoadMInstruction(cur_block, temp, operand);
             cur_block->InsertInst(cur_inst);
-            operand = genMachineVReg();
+            operand = new MachineOperand(*temp);
         }
         std::vector<MachineOperand*> temp;
         cur_block->InsertInst(new StackMInstrcuton(cur_block, StackMInstrcuton::PUSH, temp, operand));
     }
+    if (isSibling())
+    {
+        // tear down our frame and let the callee return to our caller.
+        MachineOperand *sp = new MachineOperand(MachineOperand::REG, 13);
+        cur_block->InsertInst(new BinaryMInstruction(cur_block, BinaryMInstruction::ADD, sp, sp, genMachineImm(builder->getFunction()->AllocSpace(0))));
+        cur_block->InsertInst(new BranchMInstruction(cur_block, BranchMInstruction::B, new MachineOperand(func->toStr().c_str())));
+        return;
+    }
     cur_inst = new BranchMInstruction(cur_block, BranchMInstruction::BL, new MachineOperand(func->toStr().c_str()));
     cur_block->InsertInst(cur_inst);
     if (operands.size() > 5) 
@@ -547,7 +613,7 @@ MachineOperand* Instruction::genMachineOperand(Operand* ope)
     if (se->isConstant())
         mope = new MachineOperand(MachineOperand::IMM, dynamic_cast<ConstantSymbolEntry*>(se)->getValue());
     else if (se->isTemporary())
-        mope = new MachineOperand(MachineOperand::VREG, dynamic_cast<TemporarySymbolEntry*>(se)->getLabel());
+        mope = new MachineOperand(MachineOperand::VREG, dynamic_cast<TemporarySymbolEntry*>(se)->getLabel(), se->getType()->isVector());
     else if (se->isVariable()) 
     {
         auto id_se = dynamic_cast<IdentifierSymbolEntry*>(se);
@@ -658,3 +724,189 @@ void GepInstruction::genMachineCode(AsmBuilder* builder)
         cur_block->InsertInst(cur_inst);
     }
 }
+
+VLoadInstruction::VLoadInstruction(Operand* dst, Operand* src_addr, BasicBlock* insert_bb) : Instruction(VLOAD, insert_bb) 
+{
+    operands.push_back(dst);
+    operands.push_back(src_addr);
+    dst->setDef(this);
+    src_addr->addUse(this);
+}
+
+VLoadInstruction::~VLoadInstruction() {}
+
+void VLoadInstruction::output() const {}
+
+void VLoadInstruction::genMachineCode(AsmBuilder* builder) 
+{
+    auto cur_block = builder->getBlock();
+    auto dst = genMachineOperand(operands[0]);
+    auto src = genMachineOperand(operands[1]);
+    cur_block->InsertInst(new VLoadMInstruction(cur_block, dst, src));
+}
+
+VStoreInstruction::VStoreInstruction(Operand* dst_addr, Operand* src, BasicBlock* insert_bb) : Instruction(VSTORE, insert_bb) 
+{
+    operands.push_back(dst_addr);
+    operands.push_back(src);
+    dst_addr->addUse(this);
+    src->addUse(this);
+}
+
+VStoreInstruction::~VStoreInstruction() {}
+
+void VStoreInstruction::output() const {}
+
+void VStoreInstruction::genMachineCode(AsmBuilder* builder) 
+{
+    auto cur_block = builder->getBlock();
+    auto dst = genMachineOperand(operands[0]);
+    auto src = genMachineOperand(operands[1]);
+    cur_block->InsertInst(new VStoreMInstruction(cur_block, src, dst));
+}
+
+VBinaryInstruction::VBinaryInstruction(unsigned opcode, Operand* dst, Operand* src1, Operand* src2, BasicBlock* insert_bb) : Instruction(VBINARY, insert_bb) 
+{
+    this->opcode = opcode;
+    operands.push_back(dst);
+    operands.push_back(src1);
+    operands.push_back(src2);
+    dst->setDef(this);
+    src1->addUse(this);
+    src2->addUse(this);
+}
+
+VBinaryInstruction::~VBinaryInstruction() {}
+
+void VBinaryInstruction::output() const {}
+
+void VBinaryInstruction::genMachineCode(AsmBuilder* builder) 
+{
+    auto cur_block = builder->getBlock();
+    auto dst = genMachineOperand(operands[0]);
+    auto src1 = genMachineOperand(operands[1]);
+    auto src2 = genMachineOperand(operands[2]);
+    MachineInstruction* cur_inst = nullptr;
+    switch (opcode) 
+    {
+        case ADD:
+            cur_inst = new VBinaryMInstruction(cur_block, VBinaryMInstruction::VADD, dst, src1, src2);
+            break;
+        case SUB:
+            cur_inst = new VBinaryMInstruction(cur_block, VBinaryMInstruction::VSUB, dst, src1, src2);
+            break;
+        case MUL:
+            cur_inst = new VBinaryMInstruction(cur_block, VBinaryMInstruction::VMUL, dst, src1, src2);
+            break;
+        case MAX:
+            cur_inst = new VBinaryMInstruction(cur_block, VBinaryMInstruction::VMAX, dst, src1, src2);
+            break;
+        case MIN:
+            cur_inst = new VBinaryMInstruction(cur_block, VBinaryMInstruction::VMIN, dst, src1, src2);
+            break;
+        default:
+            break;
+    }
+    cur_block->InsertInst(cur_inst);
+}
+
+VDupInstruction::VDupInstruction(Operand* dst, Operand* src, BasicBlock* insert_bb) : Instruction(VDUP, insert_bb) 
+{
+    operands.push_back(dst);
+    operands.push_back(src);
+    dst->setDef(this);
+    src->addUse(this);
+}
+
+VDupInstruction::~VDupInstruction() {}
+
+void VDupInstruction::output() const {}
+
+void VDupInstruction::genMachineCode(AsmBuilder* builder) 
+{
+    auto cur_block = builder->getBlock();
+    auto dst = genMachineOperand(operands[0]);
+    auto src = genMachineOperand(operands[1]);
+    if (src->isImm()) 
+    {
+        auto temp_reg = genMachineVReg();
+        cur_block->InsertInst(new LoadMInstruction(cur_block, temp_reg, src));
+        src = new MachineOperand(*temp_reg);
+    }
+    cur_block->InsertInst(new VDupMInstruction(cur_block, dst, src));
+}
+
+VBuildInstruction::VBuildInstruction(Operand* dst, std::vector<Operand*> srcs, BasicBlock* insert_bb) : Instruction(VBUILD, insert_bb) 
+{
+    operands.push_back(dst);
+    dst->setDef(this);
+    for (auto src : srcs)
+    {
+        operands.push_back(src);
+        src->addUse(this);
+    }
+}
+
+VBuildInstruction::~VBuildInstruction() {}
+
+void VBuildInstruction::output() const {}
+
+void VBuildInstruction::genMachineCode(AsmBuilder* builder) 
+{
+    auto cur_block = builder->getBlock();
+    auto dst = genMachineOperand(operands[0]);
+    std::vector<MachineOperand*> srcs;
+    for (auto it = operands.begin() + 1; it != operands.end(); it++)
+    {
+        auto src = genMachineOperand(*it);
+        if (src->isImm()) 
+        {
+            auto temp_reg = genMachineVReg();
+            cur_block->InsertInst(new LoadMInstruction(cur_block, temp_reg, src));
+            src = new MachineOperand(*temp_reg);
+        }
+        srcs.push_back(src);
+    }
+    cur_block->InsertInst(new VBuildMInstruction(cur_block, dst, srcs));
+}
+
+VReduceInstruction::VReduceInstruction(unsigned opcode, Operand* dst, Operand* src, BasicBlock* insert_bb) : Instruction(VREDUCE, insert_bb) 
+{
+    this->opcode = opcode;
+    operands.push_back(dst);
+    operands.push_back(src);
+    dst->setDef(this);
+    src->addUse(this);
+}
+
+VReduceInstruction::~VReduceInstruction() {}
+
+void VReduceInstruction::output() const {}
+
+void VReduceInstruction::genMachineCode(AsmBuilder* builder) 
+{
+    auto cur_block = builder->getBlock();
+    auto dst = genMachineOperand(operands[0]);
+    auto src = genMachineOperand(operands[1]);
+    // the pairwise steps need a scratch vector of their own.
+    auto temp = new MachineOperand(MachineOperand::VREG, SymbolTable::getLabel(), true);
+    int op = -1;
+    switch (opcode) 
+    {
+        case VBinaryInstruction::ADD:
+            op = VReduceMInstruction::VADD;
+            break;
+        case VBinaryInstruction::MUL:
+            op = VReduceMInstruction::VMUL;
+            break;
+        case VBinaryInstruction::MAX:
+            op = VReduceMInstruction::VMAX;
+            break;
+        case VBinaryInstruction::MIN:
+            op = VReduceMInstruction::VMIN;
+            break;
+        default:
+            break;
+    }
+    cur_block->InsertInst(new VReduceMInstruction(cur_block, op, dst, src, temp));
+}
@@ -77,7 +77,7 @@ void LinearScan::computeLiveIntervals()
         int t = -1;
         for (auto &use : du_chain.second)
             t = std::max(t, use->getParent()->getNo());
-        Interval *interval = new Interval({du_chain.first->getParent()->getNo(), t, false, 0, 0, {du_chain.first}, du_chain.second});
+        Interval *interval = new Interval({du_chain.first->getParent()->getNo(), t, false, 0, 0, du_chain.first->isVector(), {du_chain.first}, du_chain.second});
         intervals.push_back(interval);
     }
     bool change;
@@ -109,31 +109,66 @@ void LinearScan::computeLiveIntervals()
                 }
             }
     }
+    // a vreg live into or out of a block laid out before its def or after its last use covers that block too.
+    std::map<MachineOperand, std::vector<Interval *>> byReg;
+    for (auto &interval : intervals)
+        byReg[**interval->defs.begin()].push_back(interval);
+    for (auto &bb : func->getBlocks())
+    {
+        if (bb->getInsts().empty())
+            continue;
+        int first = bb->getInsts().front()->getNo();
+        int last = bb->getInsts().back()->getNo();
+        for (auto &t : bb->getLiveIn())
+            if (byReg.count(*t))
+                for (auto &interval : byReg[*t])
+                    interval->start = std::min(interval->start, first);
+        for (auto &t : bb->getLiveOut())
+            if (byReg.count(*t))
+                for (auto &interval : byReg[*t])
+                    interval->end = std::max(interval->end, last);
+    }
     sort(intervals.begin(), intervals.end(), compareStart);
 }
 
 bool LinearScan::linearScanRegisterAllocation()
 {
     bool success = true;
-    active.clear();
-    regs.clear();
-    for (int i = 4; i < 11; i++)
-        regs.push_back(i);
-    for (auto& i : intervals) 
+    // scalar vregs get r4-r10. vector vregs get the caller saved q0-q3 and q8-q15,
+    // the vectorizer keeps them inside call free loops and never needs more of them.
+    for (int vector = 0; vector < 2; vector++)
     {
-        expireOldIntervals(i);
-        
-        if (regs.empty())
+        active.clear();
+        regs.clear();
+        if (vector)
         {
-            spillAtInterval(i);
-            success = false;
-        } 
-        else 
+            for (int i = 0; i < 16; i++)
+                if (i < 4 || i > 7)
+                    regs.push_back(i);
+        }
+        else
+        {
+            for (int i = 4; i < 11; i++)
+                regs.push_back(i);
+        }
+        for (auto& i : intervals) 
         {
-            i->rreg = regs.front();
-            regs.erase(regs.begin());
-            active.push_back(i);
-            sort(active.begin(), active.end(), compareEnd);
+            if (i->vector != (vector == 1))
+                continue;
+            expireOldIntervals(i);
+            
+            if (regs.empty())
+            {
+                spillAtInterval(i);
+                success = false;
+            } 
+            else 
+            {
+                i->rreg = regs.front();
+                regs.erase(regs.begin());
+                active.push_back(i);
+                sort(active.begin(), active.end(), compareEnd);
+            }
         }
     }
     return success;
@@ -143,7 +178,8 @@ void LinearScan::modifyCode()
 {
     for (auto &interval : intervals)
     {
-        func->addSavedRegs(interval->rreg);
+        if (!interval->vector)
+            func->addSavedRegs(interval->rreg);
         for (auto def : interval->defs)
             def->setReg(interval->rreg);
         for (auto use : interval->uses)
@@ -25,8 +25,10 @@ void LiveVariableAnalysis::computeDefUse(MachineFunction *func)
     {
         for (auto inst = block->getInsts().begin(); inst != block->getInsts().end(); inst++)
         {
-            auto user = (*inst)->getUse();
-            std::set<MachineOperand *> temp(user.begin(), user.end());
+            std::set<MachineOperand *> temp;
+            for (auto &u : (*inst)->getUse())
+                if (u->isVReg())
+                    temp.insert(u);
             set_difference(temp.begin(), temp.end(),
                            def[block].begin(), def[block].end(), inserter(use[block], use[block].end()));
             auto defs = (*inst)->getDef();
@@ -45,8 +47,10 @@ void LiveVariableAnalysis::iterate(MachineFunction *func)
     while (change)
     {
         change = false;
-        for (auto &block : func->getBlocks())
+        // liveness flows backwards, visiting the blocks last to first settles it in a few rounds.
+        for (auto it = func->getBlocks().rbegin(); it != func->getBlocks().rend(); it++)
         {
+            auto block = *it;
             block->getLiveOut().clear();
             auto old = block->getLiveIn();
             for (auto &succ : block->getSuccs())
@@ -67,9 +71,11 @@ void LiveVariableAnalysis::computeUsePos(MachineFunction *func)
     {
         for (auto &inst : block->getInsts())
         {
+            // only virtual registers get allocated, immediates and physical registers would just fill the sets.
             auto uses = inst->getUse();
             for (auto &use : uses)
-                all_uses[*use].insert(use);
+                if (use->isVReg())
+                    all_uses[*use].insert(use);
         }
     }
 }
@@ -0,0 +1,122 @@
+#include "LoadElimination.h"
+#include <sstream>
+#include "AliasAnalysis.h"
+#include "Instruction.h"
+#include "Unit.h"
+
+/* Down the dominator tree, a table holds for every address the value last
+ * stored there or loaded from it. A load finding its address in the table
+ * is replaced by that value, which covers a store followed by a load of the
+ * same local as well as an array element read twice. Addresses with a
+ * known base and constant offset are the same whatever element addresses
+ * computed them. A store replaces what may alias it, a call drops what it
+ * may write, and as with value numbering a block with more than one
+ * predecessor starts with nothing known. */
+
+LoadElimination::LoadElimination(Unit* unit) : callGraph(unit)
+{
+    this->unit = unit;
+}
+
+void LoadElimination::pass()
+{
+    callGraph.pass();
+    for (auto it = unit->begin(); it != unit->end(); it++)
+    {
+        analysis.pass(*it);
+        children.clear();
+        for (auto bb : analysis.getOrder())
+            if (analysis.idom(bb))
+                children[analysis.idom(bb)].push_back(bb);
+        visit((*it)->getEntry());
+    }
+}
+
+std::string LoadElimination::key(Operand* addr)
+{
+    std::ostringstream buffer;
+    AliasAnalysis::Location loc = AliasAnalysis::locate(addr);
+    if (loc.kind != AliasAnalysis::UNKNOWN && loc.known)
+        // a parameter is named by its slot, which is a local of its own.
+        buffer << loc.kind << " " << loc.base << "+" << loc.offset;
+    else
+        buffer << addr;
+    return buffer.str();
+}
+
+// change the table, remembering how to change it back.
+void LoadElimination::set(const std::string& k, Memory m)
+{
+    auto it = table.find(k);
+    undo.push_back({k, it == table.end() ? Memory(nullptr, nullptr) : it->second});
+    if (m.first)
+        table[k] = m;
+    else if (it != table.end())
+        table.erase(it);
+}
+
+// forget what inst may write over, everything for nullptr.
+void LoadElimination::kill(Instruction* inst, const std::string& keep)
+{
+    std::vector<std::string> dead;
+    for (auto& it : table)
+    {
+        Operand* addr = it.second.first;
+        if (it.first == keep)
+            continue;
+        if (!inst || inst->isVStore() || (inst->isStore() && AliasAnalysis::mayAlias(addr, inst->getOperands()[0])) || (inst->isCall() && callGraph.mayAccess(inst, addr)))
+            dead.push_back(it.first);
+    }
+    for (auto& k : dead)
+        set(k, Memory(nullptr, nullptr));
+}
+
+void LoadElimination::visit(BasicBlock* bb)
+{
+    size_t mark = undo.size();
+    if (bb->getNumOfPred() != 1)
+        kill(nullptr);
+    for (auto inst = bb->begin(); inst != bb->end();)
+    {
+        Instruction* next = inst->getNext();
+        std::vector<Operand*>& ops = inst->getOperands();
+        if (inst->isLoad())
+        {
+            std::string k = key(ops[1]);
+            Operand* def = ops[0];
+            auto it = table.find(k);
+            if (it != table.end() && def->getDef() == inst)
+            {
+                Operand* value = it->second.second;
+                std::vector<Instruction*> users(def->use_begin(), def->use_end());
+                for (auto user : users)
+                    user->replaceUse(def, value);
+                inst->getParent()->erase(inst);
+            }
+            else
+                set(k, Memory(ops[1], def));
+        }
+        else if (inst->isStore())
+        {
+            std::string k = key(ops[0]);
+            kill(inst, k);
+            // a parameter lives in its argument register only on entry, it is read back from the slot.
+            SymbolEntry* se = ops[1]->getEntry();
+            set(k, se->isTemporary() || se->isConstant() ? Memory(ops[0], ops[1]) : Memory(nullptr, nullptr));
+        }
+        else if (inst->isVStore() || inst->isCall())
+            kill(inst);
+        inst = next;
+    }
+    for (auto child : children[bb])
+        visit(child);
+    while (undo.size() > mark)
+    {
+        auto& last = undo.back();
+        if (last.second.first)
+            table[last.first] = last.second;
+        else
+            table.erase(last.first);
+        undo.pop_back();
+    }
+}
@@ -0,0 +1,152 @@
+#include "LoopAnalysis.h"
+#include <algorithm>
+#include <iterator>
+#include "Function.h"
+
+void LoopAnalysis::pass(Function* func)
+{
+    this->func = func;
+    for (auto loop : loops)
+        delete loop;
+    loops.clear();
+    computeOrder();
+    computeDominators();
+    findLoops();
+}
+
+void LoopAnalysis::computeOrder()
+{
+    order.clear();
+    std::set<BasicBlock*> visited;
+    std::vector<std::pair<BasicBlock*, int>> stack;
+    stack.push_back({func->getEntry(), 0});
+    visited.insert(func->getEntry());
+    while (!stack.empty())
+    {
+        auto& top = stack.back();
+        BasicBlock* bb = top.first;
+        if (top.second < bb->getNumOfSucc())
+        {
+            BasicBlock* succ = *(bb->succ_begin() + top.second++);
+            if (!visited.count(succ))
+            {
+                visited.insert(succ);
+                stack.push_back({succ, 0});
+            }
+        }
+        else
+        {
+            order.push_back(bb);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+}
+
+void LoopAnalysis::computeDominators()
+{
+    doms.clear();
+    std::set<BasicBlock*> all(order.begin(), order.end());
+    for (auto bb : order)
+        doms[bb] = all;
+    doms[func->getEntry()] = {func->getEntry()};
+    bool change = true;
+    while (change)
+    {
+        change = false;
+        for (auto bb : order)
+        {
+            if (bb == func->getEntry())
+                continue;
+            std::set<BasicBlock*> temp = all;
+            for (auto pred = bb->pred_begin(); pred != bb->pred_end(); pred++)
+            {
+                if (!doms.count(*pred))
+                    continue;
+                std::set<BasicBlock*> res;
+                set_intersection(temp.begin(), temp.end(), doms[*pred].begin(), doms[*pred].end(), inserter(res, res.end()));
+                temp = res;
+            }
+            temp.insert(bb);
+            if (temp != doms[bb])
+            {
+                doms[bb] = temp;
+                change = true;
+            }
+        }
+    }
+}
+
+bool LoopAnalysis::dominates(BasicBlock* a, BasicBlock* b)
+{
+    return doms.count(b) && doms[b].count(a);
+}
+
+BasicBlock* LoopAnalysis::idom(BasicBlock* bb)
+{
+    // the strict dominator dominated by all the others.
+    for (auto dom : doms[bb])
+        if (dom != bb && doms[dom].size() + 1 == doms[bb].size())
+            return dom;
+    return nullptr;
+}
+
+void LoopAnalysis::findLoops()
+{
+    std::map<BasicBlock*, Loop*> headers;
+    for (auto bb : order)
+    {
+        for (auto succ = bb->succ_begin(); succ != bb->succ_end(); succ++)
+        {
+            BasicBlock* header = *succ;
+            if (!dominates(header, bb))
+                continue;
+            Loop* loop = headers[header];
+            if (loop == nullptr)
+            {
+                loop = new Loop({header, {header}, {}, nullptr, 1, true});
+                headers[header] = loop;
+                loops.push_back(loop);
+            }
+            loop->latches.push_back(bb);
+            // walk backwards from the latch until the header is met.
+            std::vector<BasicBlock*> worklist;
+            if (loop->blocks.insert(bb).second)
+                worklist.push_back(bb);
+            while (!worklist.empty())
+            {
+                BasicBlock* cur = worklist.back();
+                worklist.pop_back();
+                for (auto pred = cur->pred_begin(); pred != cur->pred_end(); pred++)
+                {
+                    if (reachable(*pred) && loop->blocks.insert(*pred).second)
+                        worklist.push_back(*pred);
+                }
+            }
+        }
+    }
+    sort(loops.begin(), loops.end(), [](Loop* a, Loop* b) { return a->blocks.size() < b->blocks.size(); });
+    for (size_t i = 0; i < loops.size(); i++)
+    {
+        for (size_t j = i + 1; j < loops.size(); j++)
+        {
+            if (loops[j]->blocks.count(loops[i]->header))
+            {
+                loops[i]->parent = loops[j];
+                loops[j]->inner = false;
+                break;
+            }
+        }
+    }
+    for (auto loop : loops)
+        for (Loop* p = loop->parent; p; p = p->parent)
+            loop->depth++;
+}
+
+LoopAnalysis::Loop* LoopAnalysis::getLoop(BasicBlock* bb)
+{
+    for (auto loop : loops)
+        if (loop->blocks.count(bb))
+            return loop;
+    return nullptr;
+}
@@ -0,0 +1,787 @@
+#include "LoopVectorizer.h"
+#include <algorithm>
+#include "AliasAnalysis.h"
+#include "Instruction.h"
+#include "SymbolTable.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* A loop is vectorized when it is an innermost while loop made of a header,
+ * that compares a local int i against an invariant bound, and a body that
+ * ends with i = i + 1. Every array access in the body has to be a[i + c] over
+ * ints, everything else has to be loop invariant, and the body may only add,
+ * subtract and multiply. The other scalars the body writes have to be
+ * reductions: s = s + x, s = s * x, or if (x > m) m = x, whose value is not
+ * looked at inside the loop. Each of them gets a vector of partial results,
+ * one per lane, that is combined with the scalar once the vector loop is
+ * done. The vector loop runs 4 iterations at a time while they all fit, then
+ * the original loop finishes the remainder. */
+
+LoopVectorizer::LoopVectorizer(Unit* unit)
+{
+    this->unit = unit;
+}
+
+void LoopVectorizer::pass()
+{
+    for (auto it = unit->begin(); it != unit->end(); it++)
+    {
+        func = *it;
+        LoopAnalysis analysis;
+        analysis.pass(func);
+        for (auto l : analysis.getLoops())
+        {
+            loop = l;
+            iv = step = index = bound = nullptr;
+            cond = nullptr;
+            body.clear();
+            updates.clear();
+            written.clear();
+            reductions.clear();
+            reductionOf.clear();
+            values.clear();
+            accesses.clear();
+            checks.clear();
+            if (!analyze())
+                continue;
+            std::vector<BasicBlock*>& list = func->getBlockList();
+            size_t before = list.size();
+            if (isIdiom())
+                callIdiom();
+            else
+                vectorize();
+            // the new blocks go right before the loop, what is live across the loop stays live through them.
+            std::vector<BasicBlock*> added(list.begin() + before, list.end());
+            list.erase(list.begin() + before, list.end());
+            list.insert(std::find(list.begin(), list.end(), header), added.begin(), added.end());
+        }
+    }
+}
+
+bool LoopVectorizer::inLoop(Operand* op)
+{
+    return op->getDef() && loop->blocks.count(op->getDef()->getParent());
+}
+
+bool LoopVectorizer::isInvariant(Operand* op)
+{
+    if (!inLoop(op))
+        return true;
+    return values.count(op) && values[op].kind == INVARIANT;
+}
+
+// a scalar that lives in memory: a local or a global int, or a pointer parameter.
+bool LoopVectorizer::isScalarVar(Operand* op)
+{
+    if (op->getDef())
+        return op->getDef()->isAlloc();
+    return op->isGlobalInt();
+}
+
+bool LoopVectorizer::analyze()
+{
+    if (!loop->inner || loop->latches.size() != 1)
+        return false;
+    header = loop->header;
+    preheader = nullptr;
+    for (auto pred = header->pred_begin(); pred != header->pred_end(); pred++)
+    {
+        if (loop->blocks.count(*pred))
+            continue;
+        if (preheader)
+            return false;
+        preheader = *pred;
+    }
+    if (!preheader || !preheader->rbegin()->isUncond())
+        return false;
+    Instruction* br = header->rbegin();
+    if (!br->isCond() || !loop->blocks.count(((CondBrInstruction*)br)->getTrueBranch())
+        || loop->blocks.count(((CondBrInstruction*)br)->getFalseBranch()))
+        return false;
+    cond = br->getOperands()[0]->getDef();
+    if (!cond || !cond->isCmp() || cond->getParent() != header || cond->getDef()->usersNum() != 1)
+        return false;
+
+    // one iteration in order, stepping over the update blocks of if (x > m) m = x.
+    std::set<BasicBlock*> seen = {header};
+    BasicBlock* bb = ((CondBrInstruction*)br)->getTrueBranch();
+    while (bb != header)
+    {
+        if (!loop->blocks.count(bb) || seen.count(bb))
+            return false;
+        seen.insert(bb);
+        body.push_back(bb);
+        Instruction* last = bb->rbegin();
+        if (last->isUncond())
+        {
+            bb = ((UncondBrInstruction*)last)->getBranch();
+            continue;
+        }
+        if (!last->isCond())
+            return false;
+        BasicBlock* update = ((CondBrInstruction*)last)->getTrueBranch();
+        BasicBlock* other = ((CondBrInstruction*)last)->getFalseBranch();
+        if (!loop->blocks.count(update) || seen.count(update) || !update->rbegin()->isUncond())
+            return false;
+        bb = ((UncondBrInstruction*)update->rbegin())->getBranch();
+        seen.insert(update);
+        updates.insert(update);
+        if (other != bb)
+        {
+            if (!loop->blocks.count(other) || seen.count(other) || other->begin() != other->rbegin() || !other->rbegin()->isUncond()
+                || ((UncondBrInstruction*)other->rbegin())->getBranch() != bb)
+                return false;
+            seen.insert(other);
+        }
+    }
+    if (seen.size() != loop->blocks.size())
+        return false;
+
+    for (auto bb : loop->blocks)
+    {
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+        {
+            if (inst->isCall())
+                return false;
+            if (inst->isStore())
+            {
+                Operand* addr = inst->getOperands()[0];
+                if (!addr->getDef() || !addr->getDef()->isGep())
+                    written.insert(addr);
+            }
+        }
+    }
+    // the induction variable is the scalar the exit test counts with, every other one has to be a reduction.
+    for (auto op : cond->getUse())
+    {
+        Instruction* def = op->getDef();
+        while (def && def->isBinary() && def->getOperands()[2]->getEntry()->isConstant())
+            def = def->getOperands()[1]->getDef();
+        if (def && def->isLoad() && written.count(def->getOperands()[1]))
+        {
+            if (iv)
+                return false;
+            iv = def->getOperands()[1];
+        }
+    }
+    if (!iv || !iv->getDef() || !iv->getDef()->isAlloc() || !((PointerType*)iv->getType())->getType()->isInt())
+        return false;
+    for (auto var : written)
+    {
+        if (var == iv)
+            continue;
+        if (!isScalarVar(var) || !((PointerType*)var->getType())->getType()->isInt())
+            return false;
+        reductionOf[var] = reductions.size();
+        reductions.push_back({var, -1, nullptr, false, nullptr, nullptr, nullptr});
+    }
+
+    for (auto inst = header->begin(); inst != cond; inst = inst->getNext())
+        if (inst->isStore() || (inst->isLoad() && reductionOf.count(inst->getOperands()[1])) || !classify(inst))
+            return false;
+    if (cond->getNext() != br)
+        return false;
+    index = cond->getOperands()[1];
+    bound = cond->getOperands()[2];
+    if (cond->getOpcode() == CmpInstruction::G || cond->getOpcode() == CmpInstruction::GE)
+        std::swap(index, bound);
+    else if (cond->getOpcode() != CmpInstruction::L && cond->getOpcode() != CmpInstruction::LE)
+        return false;
+    if (!values.count(index) || values[index].kind != INDEX || !isInvariant(bound))
+        return false;
+
+    for (auto bb : body)
+    {
+        Instruction* last = bb->rbegin();
+        Instruction* end = last->isCond() ? last->getPrev() : last;
+        if (last->isCond() && (!end->isCmp() || end->getDef() != last->getOperands()[0] || end->getDef()->usersNum() != 1))
+            return false;
+        for (auto inst = bb->begin(); inst != end; inst = inst->getNext())
+            if (!classify(inst))
+                return false;
+        if (last->isCond())
+        {
+            // the update block reloads x, which must not have been overwritten in between.
+            for (auto& access : accesses)
+                if (access.store)
+                    return false;
+            if (!classifyMinMax(end, ((CondBrInstruction*)last)->getTrueBranch()))
+                return false;
+        }
+    }
+    if (!step)
+        return false;
+    for (auto& r : reductions)
+        if (r.kind == -1 || !r.stored)
+            return false;
+
+    // every vector value, accumulator and broadcast scalar needs its own quad register.
+    int vectors = reductions.size();
+    bool stores = false;
+    for (auto bb : body)
+    {
+        for (auto inst = bb->begin(); inst != bb->rbegin(); inst = inst->getNext())
+        {
+            Operand* def = inst->getDef();
+            int kind = def && values.count(def) ? values[def].kind : -1;
+            if (kind == VECTOR)
+                vectors++;
+            if (kind == VECTOR || kind == REDUCTION || inst->isCmp())
+                for (auto use : inst->getUse())
+                    if ((inst->isBinary() || inst->isCmp()) && isInvariant(use))
+                        vectors++;
+            if (inst->isStore() && inst->getOperands()[0] != iv && !reductionOf.count(inst->getOperands()[0]))
+            {
+                stores = true;
+                if (isInvariant(inst->getOperands()[1]))
+                    vectors++;
+            }
+        }
+    }
+    if ((!stores && reductions.empty()) || vectors > maxVectors)
+        return false;
+    return checkDependences();
+}
+
+bool LoopVectorizer::classify(Instruction* inst)
+{
+    auto kindOf = [this](Operand* op) {
+        if (isInvariant(op))
+            return (int)INVARIANT;
+        if (values.count(op))
+            return values[op].kind;
+        return -1;
+    };
+    auto isConst = [](Operand* op) { return op->getEntry()->isConstant(); };
+    auto constOf = [](Operand* op) { return ((ConstantSymbolEntry*)op->getEntry())->getValue(); };
+    std::vector<Operand*>& ops = inst->getOperands();
+    if (inst->isLoad())
+    {
+        Operand* addr = ops[1];
+        if (addr == iv)
+        {
+            if (step)
+                return false;
+            values[ops[0]] = {INDEX, 0, nullptr};
+            return true;
+        }
+        if (reductionOf.count(addr))
+        {
+            Reduction& r = reductions[reductionOf[addr]];
+            if (r.load || ops[0]->usersNum() != 1)
+                return false;
+            r.load = ops[0];
+            values[ops[0]] = {REDUCTION, reductionOf[addr], nullptr};
+            return true;
+        }
+        if (kindOf(addr) == ADDR)
+        {
+            values[ops[0]] = {VECTOR, 0, nullptr};
+            accesses.push_back({addr, values[addr].base, values[addr].offset, false});
+            return true;
+        }
+        if (isScalarVar(addr) && !written.count(addr))
+        {
+            values[ops[0]] = {INVARIANT, 0, nullptr};
+            return true;
+        }
+        return false;
+    }
+    if (inst->isGep())
+    {
+        if (!isInvariant(ops[1]))
+            return false;
+        if (isInvariant(ops[2]))
+        {
+            values[ops[0]] = {INVARIANT, 0, nullptr};
+            return true;
+        }
+        if (kindOf(ops[2]) == INDEX && ((PointerType*)ops[0]->getType())->getType()->isInt())
+        {
+            values[ops[0]] = {ADDR, values[ops[2]].offset, ops[1]};
+            return true;
+        }
+        return false;
+    }
+    if (inst->isBinary())
+    {
+        int k1 = kindOf(ops[1]), k2 = kindOf(ops[2]);
+        unsigned opcode = inst->getOpcode();
+        if (k1 == INVARIANT && k2 == INVARIANT)
+        {
+            values[ops[0]] = {INVARIANT, 0, nullptr};
+            return true;
+        }
+        if (k1 == INDEX && isConst(ops[2]) && (opcode == BinaryInstruction::ADD || opcode == BinaryInstruction::SUB))
+        {
+            int c = opcode == BinaryInstruction::ADD ? constOf(ops[2]) : -constOf(ops[2]);
+            values[ops[0]] = {INDEX, values[ops[1]].offset + c, nullptr};
+            return true;
+        }
+        if (k2 == INDEX && isConst(ops[1]) && opcode == BinaryInstruction::ADD)
+        {
+            values[ops[0]] = {INDEX, values[ops[2]].offset + constOf(ops[1]), nullptr};
+            return true;
+        }
+        if (k1 == REDUCTION || k2 == REDUCTION)
+        {
+            // s + x1 + x2 is reassociated into s + (x1 + x2), which is exact for wrapping int add and mul.
+            Operand* acc = k1 == REDUCTION ? ops[1] : ops[2];
+            int kx = k1 == REDUCTION ? k2 : k1;
+            int kind = opcode == BinaryInstruction::MUL ? VBinaryInstruction::MUL : VBinaryInstruction::ADD;
+            Reduction& r = reductions[values[acc].offset];
+            if ((kx != VECTOR && kx != INVARIANT) || acc->usersNum() != 1 || (r.kind != -1 && r.kind != kind))
+                return false;
+            if (opcode != BinaryInstruction::ADD && opcode != BinaryInstruction::MUL && (opcode != BinaryInstruction::SUB || k1 != REDUCTION))
+                return false;
+            r.kind = kind;
+            values[ops[0]] = {REDUCTION, values[acc].offset, nullptr};
+            return true;
+        }
+        if ((k1 == VECTOR || k2 == VECTOR) && (k1 == VECTOR || k1 == INVARIANT) && (k2 == VECTOR || k2 == INVARIANT)
+            && (opcode == BinaryInstruction::ADD || opcode == BinaryInstruction::SUB || opcode == BinaryInstruction::MUL))
+        {
+            values[ops[0]] = {VECTOR, 0, nullptr};
+            return true;
+        }
+        return false;
+    }
+    if (inst->isStore())
+    {
+        Operand* addr = ops[0];
+        Operand* val = ops[1];
+        if (addr == iv)
+        {
+            // i = i + 1, after which i may not be read again.
+            Instruction* def = val->getDef();
+            if (step || !def || !def->isBinary() || def->getOpcode() != BinaryInstruction::ADD)
+                return false;
+            if (kindOf(val) != INDEX || values[val].offset != 1)
+                return false;
+            for (auto use : def->getUse())
+                if (kindOf(use) == INDEX && values[use].offset == 0)
+                    step = use;
+            return step != nullptr;
+        }
+        if (reductionOf.count(addr))
+        {
+            Reduction& r = reductions[reductionOf[addr]];
+            if (r.stored || kindOf(val) != REDUCTION || values[val].offset != reductionOf[addr] || val->usersNum() != 1)
+                return false;
+            r.stored = true;
+            return true;
+        }
+        if (kindOf(addr) == ADDR && (kindOf(val) == VECTOR || kindOf(val) == INVARIANT))
+        {
+            accesses.push_back({addr, values[addr].base, values[addr].offset, true});
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+// if (x > m) m = x is m = max(m, x), the same goes for the other compares and min.
+bool LoopVectorizer::classifyMinMax(Instruction* cmp, BasicBlock* update)
+{
+    Operand* x = cmp->getOperands()[1];
+    Operand* var = cmp->getOperands()[2];
+    unsigned opcode = cmp->getOpcode();
+    if (values.count(x) && values[x].kind == REDUCTION)
+    {
+        std::swap(x, var);
+        if (opcode == CmpInstruction::L || opcode == CmpInstruction::LE)
+            opcode += CmpInstruction::G - CmpInstruction::L;
+        else if (opcode == CmpInstruction::G || opcode == CmpInstruction::GE)
+            opcode -= CmpInstruction::G - CmpInstruction::L;
+    }
+    if (!values.count(var) || values[var].kind != REDUCTION || (!isInvariant(x) && values[x].kind != VECTOR))
+        return false;
+    Reduction& r = reductions[values[var].offset];
+    if (r.kind != -1 || r.stored)
+        return false;
+    if (opcode == CmpInstruction::G || opcode == CmpInstruction::GE)
+        r.kind = VBinaryInstruction::MAX;
+    else if (opcode == CmpInstruction::L || opcode == CmpInstruction::LE)
+        r.kind = VBinaryInstruction::MIN;
+    else
+        return false;
+    // the update block may only compute x again before storing it.
+    Instruction* store = update->rbegin()->getPrev();
+    if (!store->isStore() || store->getOperands()[0] != r.var)
+        return false;
+    for (auto inst = update->begin(); inst != store; inst = inst->getNext())
+        if (inst->isStore() || !classify(inst))
+            return false;
+    if (!sameLanes(store->getOperands()[1], x))
+        return false;
+    r.cmp = cmp;
+    r.cand = x;
+    r.stored = true;
+    return true;
+}
+
+// whether two operands of the loop hold the same value in every lane, loads of the same element included.
+bool LoopVectorizer::sameLanes(Operand* a, Operand* b)
+{
+    if (isInvariant(a) && isInvariant(b))
+        return sameValue(a, b);
+    if (!values.count(a) || !values.count(b) || values[a].kind != VECTOR || values[b].kind != VECTOR)
+        return false;
+    Instruction* da = a->getDef();
+    Instruction* db = b->getDef();
+    if (da->isLoad() && db->isLoad())
+    {
+        Value& va = values[da->getOperands()[1]];
+        Value& vb = values[db->getOperands()[1]];
+        return va.offset == vb.offset && sameValue(va.base, vb.base);
+    }
+    if (da->isBinary() && db->isBinary() && da->getOpcode() == db->getOpcode())
+        return sameLanes(da->getOperands()[1], db->getOperands()[1]) && sameLanes(da->getOperands()[2], db->getOperands()[2]);
+    return false;
+}
+
+// whether two operands of the loop always hold the same value in an iteration.
+bool LoopVectorizer::sameValue(Operand* a, Operand* b)
+{
+    if (a == b)
+        return true;
+    if (a->getEntry()->isConstant() && b->getEntry()->isConstant())
+        return ((ConstantSymbolEntry*)a->getEntry())->getValue() == ((ConstantSymbolEntry*)b->getEntry())->getValue();
+    if (!inLoop(a) || !inLoop(b))
+        return false;
+    Instruction* da = a->getDef();
+    Instruction* db = b->getDef();
+    if (da->isLoad() && db->isLoad())
+        return da->getOperands()[1] == db->getOperands()[1];
+    if ((da->isGep() && db->isGep()) || (da->isBinary() && db->isBinary() && da->getOpcode() == db->getOpcode()))
+        return sameValue(da->getOperands()[1], db->getOperands()[1]) && sameValue(da->getOperands()[2], db->getOperands()[2]);
+    return false;
+}
+
+/* With all accesses at i + c, two accesses to the same array only conflict
+ * when they are less than a vector apart, so a pair is safe when the
+ * distance of its addresses is 0 or at least 16 bytes. Distinct local and
+ * global arrays never overlap, and a parameter can't point into our own
+ * frame, the rest is decided at run time. */
+bool LoopVectorizer::checkDependences()
+{
+    for (size_t k = 0; k < accesses.size(); k++)
+    {
+        for (size_t l = k + 1; l < accesses.size(); l++)
+        {
+            Access& a = accesses[k];
+            Access& b = accesses[l];
+            if (!a.store && !b.store)
+                continue;
+            bool pa, pb;
+            Operand* ra = AliasAnalysis::root(a.base, pa);
+            Operand* rb = AliasAnalysis::root(b.base, pb);
+            if (ra != rb && !pa && !pb)
+                continue;
+            if (ra != rb && ((!pa && ra->getDef()) || (!pb && rb->getDef())))
+                continue;
+            if (sameValue(a.base, b.base))
+            {
+                int dist = a.offset - b.offset;
+                if (dist == 0 || dist >= width || dist <= -width)
+                    continue;
+                return false;
+            }
+            checks.push_back({k, l});
+        }
+    }
+    return checks.size() <= maxChecks;
+}
+
+// copy the computation of a scalar loop operand to the end of bb.
+Operand* LoopVectorizer::materialize(Operand* op, BasicBlock* bb)
+{
+    if (!inLoop(op))
+        return op;
+    if (vmap.count(op))
+        return vmap[op];
+    Instruction* inst = op->getDef();
+    Instruction* copy = inst->copy();
+    for (auto use : inst->getUse())
+        copy->replaceUse(use, materialize(use, bb));
+    Operand* def = Operand::temporary(op->getType());
+    copy->replaceDef(def);
+    bb->insertBack(copy);
+    vmap[op] = def;
+    return def;
+}
+
+Operand* LoopVectorizer::vectorOf(Operand* op, BasicBlock* bb, std::map<Operand*, Operand*>& dups)
+{
+    if (!isInvariant(op))
+        return vmap[op];
+    if (!dups.count(op))
+    {
+        dups[op] = Operand::temporary(TypeSystem::vectorIntType);
+        new VDupInstruction(dups[op], materialize(op, bb), bb);
+    }
+    return dups[op];
+}
+
+void LoopVectorizer::link(BasicBlock* from, BasicBlock* to)
+{
+    from->addSucc(to);
+    to->addPred(from);
+}
+
+void LoopVectorizer::unlink(BasicBlock* from, BasicBlock* to)
+{
+    from->removeSucc(to);
+    to->removePred(from);
+}
+
+void LoopVectorizer::vectorize()
+{
+    // alias checks, every pair falls through to the next one when it is far
+    // enough apart and gives up on the vector loop otherwise.
+    BasicBlock* first = nullptr;
+    std::vector<CondBrInstruction*> passes;
+    auto passTo = [&](BasicBlock* bb) {
+        if (passes.empty())
+            first = bb;
+        for (auto br : passes)
+        {
+            br->setTrueBranch(bb);
+            link(br->getParent(), bb);
+        }
+        passes.clear();
+    };
+    for (auto& check : checks)
+    {
+        BasicBlock* ge = new BasicBlock(func);
+        BasicBlock* le = new BasicBlock(func);
+        BasicBlock* eq = new BasicBlock(func);
+        passTo(ge);
+        vmap.clear();
+        Operand* a = materialize(accesses[check.first].addr, ge);
+        Operand* b = materialize(accesses[check.second].addr, ge);
+        Operand* dist = Operand::temporary(TypeSystem::intType);
+        new BinaryInstruction(BinaryInstruction::SUB, dist, a, b, ge);
+        std::vector<std::pair<BasicBlock*, BasicBlock*>> tests = {{ge, le}, {le, eq}, {eq, header}};
+        std::vector<std::pair<unsigned, int>> conds = {{CmpInstruction::GE, width * 4}, {CmpInstruction::LE, -width * 4}, {CmpInstruction::E, 0}};
+        for (size_t i = 0; i < tests.size(); i++)
+        {
+            BasicBlock* bb = tests[i].first;
+            Operand* flag = Operand::temporary(TypeSystem::boolType);
+            new CmpInstruction(conds[i].first, flag, dist, Operand::constant(conds[i].second), bb);
+            passes.push_back(new CondBrInstruction(nullptr, tests[i].second, flag, bb));
+            link(bb, tests[i].second);
+        }
+    }
+    // the blocks are laid out in this order, so the accumulators stay live
+    // from the vector preheader through the loop to the exit block.
+    BasicBlock* vpreheader = reductions.empty() ? nullptr : new BasicBlock(func);
+    BasicBlock* vheader = new BasicBlock(func);
+    BasicBlock* vbody = new BasicBlock(func);
+    BasicBlock* vexit = reductions.empty() ? header : new BasicBlock(func);
+    passTo(vpreheader ? vpreheader : vheader);
+    ((UncondBrInstruction*)preheader->rbegin())->setBranch(first);
+    unlink(preheader, header);
+    link(preheader, first);
+
+    // sums start from 0 and products from 1, max and min from the current value.
+    if (vpreheader)
+    {
+        for (auto& r : reductions)
+        {
+            r.acc = Operand::temporary(TypeSystem::vectorIntType);
+            Operand* init;
+            if (r.kind == VBinaryInstruction::ADD)
+                init = Operand::constant(0);
+            else if (r.kind == VBinaryInstruction::MUL)
+                init = Operand::constant(1);
+            else
+            {
+                init = Operand::temporary(TypeSystem::intType);
+                new LoadInstruction(init, r.var, vpreheader);
+            }
+            new VDupInstruction(r.acc, init, vpreheader);
+        }
+        new UncondBrInstruction(vheader, vpreheader);
+        link(vpreheader, vheader);
+    }
+
+    // vector header: i + 3 against the bound.
+    vmap.clear();
+    for (auto inst = header->begin(); inst != cond; inst = inst->getNext())
+        materialize(inst->getDef(), vheader);
+    Operand* limit = Operand::temporary(TypeSystem::intType);
+    new BinaryInstruction(BinaryInstruction::SUB, limit, materialize(bound, vheader), Operand::constant(width - 1), vheader);
+    Operand* flag = Operand::temporary(TypeSystem::boolType);
+    unsigned opcode = cond->getOpcode();
+    if (opcode == CmpInstruction::G)
+        opcode = CmpInstruction::L;
+    else if (opcode == CmpInstruction::GE)
+        opcode = CmpInstruction::LE;
+    new CmpInstruction(opcode, flag, materialize(index, vheader), limit, vheader);
+    new CondBrInstruction(vbody, vexit, flag, vheader);
+    link(vheader, vbody);
+    link(vheader, vexit);
+
+    // vector body, in the order of the scalar one.
+    std::map<Operand*, Operand*> dups;
+    auto vectorOpcode = [](unsigned opcode) {
+        if (opcode == BinaryInstruction::ADD)
+            return (unsigned)VBinaryInstruction::ADD;
+        if (opcode == BinaryInstruction::SUB)
+            return (unsigned)VBinaryInstruction::SUB;
+        return (unsigned)VBinaryInstruction::MUL;
+    };
+    for (auto bb : body)
+    {
+        for (auto inst = bb->begin(); inst != bb->rbegin(); inst = inst->getNext())
+        {
+            std::vector<Operand*>& ops = inst->getOperands();
+            if (inst->isCmp())
+            {
+                for (auto& r : reductions)
+                    if (r.cmp == inst)
+                        new VBinaryInstruction(r.kind, r.acc, r.acc, vectorOf(r.cand, vbody, dups), vbody);
+                continue;
+            }
+            if (inst->isStore())
+            {
+                if (ops[0] == iv)
+                {
+                    Operand* next = Operand::temporary(TypeSystem::intType);
+                    new BinaryInstruction(BinaryInstruction::ADD, next, materialize(step, vbody), Operand::constant(width), vbody);
+                    new StoreInstruction(iv, next, vbody);
+                }
+                else if (!reductionOf.count(ops[0]))
+                    new VStoreInstruction(materialize(ops[0], vbody), vectorOf(ops[1], vbody, dups), vbody);
+                continue;
+            }
+            Operand* def = inst->getDef();
+            if (values[def].kind == REDUCTION)
+            {
+                // the accumulator takes the place of the scalar, one lane per iteration.
+                if (inst->isBinary())
+                {
+                    Reduction& r = reductions[values[def].offset];
+                    bool left = values.count(ops[1]) && values[ops[1]].kind == REDUCTION;
+                    unsigned opcode = inst->getOpcode() == BinaryInstruction::SUB ? (unsigned)VBinaryInstruction::SUB : r.kind;
+                    new VBinaryInstruction(opcode, r.acc, r.acc, vectorOf(left ? ops[2] : ops[1], vbody, dups), vbody);
+                }
+                continue;
+            }
+            if (values[def].kind != VECTOR)
+            {
+                materialize(def, vbody);
+                continue;
+            }
+            vmap[def] = Operand::temporary(TypeSystem::vectorIntType);
+            if (inst->isLoad())
+                new VLoadInstruction(vmap[def], materialize(ops[1], vbody), vbody);
+            else
+                new VBinaryInstruction(vectorOpcode(inst->getOpcode()), vmap[def], vectorOf(ops[1], vbody, dups), vectorOf(ops[2], vbody, dups), vbody);
+        }
+    }
+    new UncondBrInstruction(vheader, vbody);
+    link(vbody, vheader);
+
+    // fold the lanes into the scalars before the original loop does the remainder.
+    if (vexit != header)
+    {
+        for (auto& r : reductions)
+        {
+            Operand* lanes = Operand::temporary(TypeSystem::intType);
+            new VReduceInstruction(r.kind, lanes, r.acc, vexit);
+            if (r.kind == VBinaryInstruction::MAX || r.kind == VBinaryInstruction::MIN)
+            {
+                new StoreInstruction(r.var, lanes, vexit);
+                continue;
+            }
+            Operand* val = Operand::temporary(TypeSystem::intType);
+            Operand* res = Operand::temporary(TypeSystem::intType);
+            new LoadInstruction(val, r.var, vexit);
+            new BinaryInstruction(r.kind == VBinaryInstruction::ADD ? BinaryInstruction::ADD : BinaryInstruction::MUL, res, val, lanes, vexit);
+            new StoreInstruction(r.var, res, vexit);
+        }
+        new UncondBrInstruction(header, vexit);
+        link(vexit, header);
+    }
+}
+
+// a[i] = x or a[i] = b[i] and nothing else, which the runtime does in bulk.
+bool LoopVectorizer::isIdiom()
+{
+    if (!reductions.empty() || accesses.size() > 2 || !accesses.back().store)
+        return false;
+    if (accesses.size() == 1)
+        return true;
+    if (accesses[0].store)
+        return false;
+    for (auto bb : body)
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            if (inst->isStore() && inst->getOperands()[0] == accesses[1].addr)
+            {
+                Instruction* def = inst->getOperands()[1]->getDef();
+                return def && def->isLoad() && def->getOperands()[1] == accesses[0].addr;
+            }
+    return false;
+}
+
+/* The loop is entered through a guard that calls _sysy_fill or _sysy_copy
+ * for all of its iterations and leaves i where the loop would. The copy
+ * goes front to back, so it matches the loop even when the arrays overlap,
+ * and no alias checks are needed. */
+void LoopVectorizer::callIdiom()
+{
+    BasicBlock* guard = new BasicBlock(func);
+    BasicBlock* call = new BasicBlock(func);
+    ((UncondBrInstruction*)preheader->rbegin())->setBranch(guard);
+    unlink(preheader, header);
+    link(preheader, guard);
+
+    vmap.clear();
+    for (auto inst = header->begin(); inst != cond; inst = inst->getNext())
+        materialize(inst->getDef(), guard);
+    Operand* start = materialize(index, guard);
+    Operand* end = materialize(bound, guard);
+    Operand* flag = Operand::temporary(TypeSystem::boolType);
+    unsigned opcode = cond->getOpcode();
+    if (opcode == CmpInstruction::G)
+        opcode = CmpInstruction::L;
+    else if (opcode == CmpInstruction::GE)
+        opcode = CmpInstruction::LE;
+    new CmpInstruction(opcode, flag, start, end, guard);
+    new CondBrInstruction(call, header, flag, guard);
+    link(guard, call);
+    link(guard, header);
+
+    Operand* count = Operand::temporary(TypeSystem::intType);
+    new BinaryInstruction(BinaryInstruction::SUB, count, end, start, call);
+    if (opcode == CmpInstruction::LE)
+    {
+        Operand* inclusive = Operand::temporary(TypeSystem::intType);
+        new BinaryInstruction(BinaryInstruction::ADD, inclusive, count, Operand::constant(1), call);
+        count = inclusive;
+    }
+    Access& store = accesses.back();
+    Operand* dst = materialize(store.addr, call);
+    Type* array = new PointerType(TypeSystem::intType);
+    if (accesses.size() == 2)
+        new CallInstruction(nullptr, unit->declare("_sysy_copy", TypeSystem::voidType, {array, array, TypeSystem::intType}), {dst, materialize(accesses[0].addr, call), count}, call);
+    else
+    {
+        Operand* val = nullptr;
+        for (auto bb : body)
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+                if (inst->isStore() && inst->getOperands()[0] == store.addr)
+                    val = inst->getOperands()[1];
+        new CallInstruction(nullptr, unit->declare("_sysy_fill", TypeSystem::voidType, {array, TypeSystem::intType, TypeSystem::intType}), {dst, materialize(val, call), count}, call);
+    }
+    Operand* first = Operand::temporary(TypeSystem::intType);
+    Operand* last = Operand::temporary(TypeSystem::intType);
+    new LoadInstruction(first, iv, call);
+    new BinaryInstruction(BinaryInstruction::ADD, last, first, count, call);
+    new StoreInstruction(iv, last, call);
+    new UncondBrInstruction(header, call);
+    link(call, header);
+}
@@ -5,32 +5,12 @@ extern FILE* yyout;
 
 void MachineBlock::output() 
 {
-    int offset = (parent->getSavedRegs().size() + 2) * 4;
-    int num = parent->getParamsNum();
-    int count = 0;
     if (!inst_list.empty()) 
     {
         fprintf(yyout, ".L%d:\n", this->no);
         for (long unsigned int i = 0; i < inst_list.size(); i++) 
         {
-            if (num > 4 && (inst_list[i])->isStore()) 
-            {
-                MachineOperand* operand = (inst_list[i])->getUse()[0];
-                if (operand->isReg() && operand->getReg() == 0) 
-                {
-                    if (count != 0) 
-                    {
-                        count++;
-                    } 
-                    else 
-                    {
-                        offset += 4;
-                        LoadMInstruction *cur_inst = new LoadMInstruction(this, new MachineOperand(MachineOperand::REG, 0), new MachineOperand(MachineOperand::REG, 11), new MachineOperand(MachineOperand::IMM, offset));
-                        cur_inst->output();
-                    }
-                }
-            }
-            if ((inst_list[i])->isBX()) 
+            if ((inst_list[i])->isBX() || (inst_list[i])->isTailCall()) 
             {
                 auto cur_inst = new StackMInstrcuton(this, StackMInstrcuton::POP, parent->getSavedRegs(), new MachineOperand(MachineOperand::REG, 11), new MachineOperand(MachineOperand::REG, 14));
                 cur_inst->output();
@@ -39,20 +19,22 @@ void MachineBlock::output()
             {
                 auto dst = inst_list[i]->getDef()[0];
                 auto src1 = inst_list[i]->getUse()[0];
-                if (dst->isReg() && dst->getReg() == 13 && src1->isReg() && src1->getReg() == 13 && (inst_list[i + 1])->isBX()) 
+                if (dst->isReg() && dst->getReg() == 13 && src1->isReg() && src1->getReg() == 13 && ((inst_list[i + 1])->isBX() || (inst_list[i + 1])->isTailCall())) 
                 {
-                    int size = parent->AllocSpace(0);
-                    (inst_list[i])->getUse()[1]->setVal(size);
+                    (new BinaryMInstruction(this, BinaryMInstruction::ADD, dst, src1, parent->frameSize()))->output();
+                    continue;
                 }
             }
+            parent->getParent()->reachPool();
             (inst_list[i])->output();
         }
     }
 }
 
-MachineOperand::MachineOperand(int tp, int val) 
+MachineOperand::MachineOperand(int tp, int val, bool vector) 
 {
     this->type = tp;
+    this->vector = vector;
     if (tp == MachineOperand::IMM)
         this->val = val;
     else
@@ -62,11 +44,17 @@ MachineOperand::MachineOperand(int tp, int val)
 MachineOperand::MachineOperand(std::string label) 
 {
     this->type = MachineOperand::LABEL;
+    this->vector = false;
     this->label = label;
 }
 
 void MachineOperand::PrintReg() 
 {
+    if (vector)
+    {
+        fprintf(yyout, "q%d", reg_no);
+        return;
+    }
     switch (reg_no) 
     {
         case 11:
@@ -444,6 +432,186 @@ void StackMInstrcuton::output()
     fprintf(yyout, "}\n");
 }
 
+VLoadMInstruction::VLoadMInstruction(MachineBlock* p, MachineOperand* dst, MachineOperand* src, int cond)
+{
+    this->parent = p;
+    this->type = MachineInstruction::VLOAD;
+    this->op = -1;
+    this->cond = cond;
+    this->def_list.push_back(dst);
+    this->use_list.push_back(src);
+    dst->setParent(this);
+    src->setParent(this);
+}
+
+void VLoadMInstruction::output() 
+{
+    fprintf(yyout, "\tvld1.32 {");
+    this->def_list[0]->output();
+    fprintf(yyout, "}, [");
+    this->use_list[0]->output();
+    fprintf(yyout, "]\n");
+}
+
+VStoreMInstruction::VStoreMInstruction(MachineBlock* p, MachineOperand* src1, MachineOperand* src2, int cond)
+{
+    this->parent = p;
+    this->type = MachineInstruction::VSTORE;
+    this->op = -1;
+    this->cond = cond;
+    this->use_list.push_back(src1);
+    this->use_list.push_back(src2);
+    src1->setParent(this);
+    src2->setParent(this);
+}
+
+void VStoreMInstruction::output() 
+{
+    fprintf(yyout, "\tvst1.32 {");
+    this->use_list[0]->output();
+    fprintf(yyout, "}, [");
+    this->use_list[1]->output();
+    fprintf(yyout, "]\n");
+}
+
+VBinaryMInstruction::VBinaryMInstruction(MachineBlock* p, int op, MachineOperand* dst, MachineOperand* src1, MachineOperand* src2, int cond) 
+{
+    this->parent = p;
+    this->type = MachineInstruction::VBINARY;
+    this->op = op;
+    this->cond = cond;
+    this->def_list.push_back(dst);
+    this->use_list.push_back(src1);
+    this->use_list.push_back(src2);
+    dst->setParent(this);
+    src1->setParent(this);
+    src2->setParent(this);
+}
+
+void VBinaryMInstruction::output() 
+{
+    switch (this->op) 
+    {
+        case VBinaryMInstruction::VADD:
+            fprintf(yyout, "\tvadd.i32 ");
+            break;
+        case VBinaryMInstruction::VSUB:
+            fprintf(yyout, "\tvsub.i32 ");
+            break;
+        case VBinaryMInstruction::VMUL:
+            fprintf(yyout, "\tvmul.i32 ");
+            break;
+        case VBinaryMInstruction::VMAX:
+            fprintf(yyout, "\tvmax.s32 ");
+            break;
+        case VBinaryMInstruction::VMIN:
+            fprintf(yyout, "\tvmin.s32 ");
+            break;
+        default:
+            break;
+    }
+    this->def_list[0]->output();
+    fprintf(yyout, ", ");
+    this->use_list[0]->output();
+    fprintf(yyout, ", ");
+    this->use_list[1]->output();
+    fprintf(yyout, "\n");
+}
+
+VDupMInstruction::VDupMInstruction(MachineBlock* p, MachineOperand* dst, MachineOperand* src, int cond)
+{
+    this->parent = p;
+    this->type = MachineInstruction::VDUP;
+    this->op = -1;
+    this->cond = cond;
+    this->def_list.push_back(dst);
+    this->use_list.push_back(src);
+    dst->setParent(this);
+    src->setParent(this);
+}
+
+void VDupMInstruction::output() 
+{
+    fprintf(yyout, "\tvdup.32 ");
+    this->def_list[0]->output();
+    fprintf(yyout, ", ");
+    this->use_list[0]->output();
+    fprintf(yyout, "\n");
+}
+
+VBuildMInstruction::VBuildMInstruction(MachineBlock* p, MachineOperand* dst, std::vector<MachineOperand*> srcs, int cond)
+{
+    this->parent = p;
+    this->type = MachineInstruction::VBUILD;
+    this->op = -1;
+    this->cond = cond;
+    this->def_list.push_back(dst);
+    dst->setParent(this);
+    for (auto src : srcs)
+    {
+        this->use_list.push_back(src);
+        src->setParent(this);
+    }
+}
+
+void VBuildMInstruction::output() 
+{
+    // lane i of qn is lane i % 2 of d2n + i / 2.
+    int d = this->def_list[0]->getReg() * 2;
+    for (size_t i = 0; i < this->use_list.size(); i++)
+    {
+        fprintf(yyout, "\tvmov.32 d%d[%d], ", d + (int)i / 2, (int)i % 2);
+        this->use_list[i]->output();
+        fprintf(yyout, "\n");
+    }
+}
+
+VReduceMInstruction::VReduceMInstruction(MachineBlock* p, int op, MachineOperand* dst, MachineOperand* src, MachineOperand* temp, int cond)
+{
+    this->parent = p;
+    this->type = MachineInstruction::VREDUCE;
+    this->op = op;
+    this->cond = cond;
+    this->def_list.push_back(dst);
+    this->def_list.push_back(temp);
+    this->use_list.push_back(src);
+    dst->setParent(this);
+    temp->setParent(this);
+    src->setParent(this);
+}
+
+void VReduceMInstruction::output() 
+{
+    // qn is made of d2n and d2n+1.
+    int s = this->use_list[0]->getReg() * 2;
+    int t = this->def_list[1]->getReg() * 2;
+    switch (this->op) 
+    {
+        case VReduceMInstruction::VADD:
+            fprintf(yyout, "\tvadd.i32 d%d, d%d, d%d\n", t, s, s + 1);
+            fprintf(yyout, "\tvpadd.i32 d%d, d%d, d%d\n", t, t, t);
+            break;
+        case VReduceMInstruction::VMUL:
+            fprintf(yyout, "\tvmul.i32 d%d, d%d, d%d\n", t, s, s + 1);
+            fprintf(yyout, "\tvrev64.32 d%d, d%d\n", t + 1, t);
+            fprintf(yyout, "\tvmul.i32 d%d, d%d, d%d\n", t, t, t + 1);
+            break;
+        case VReduceMInstruction::VMAX:
+            fprintf(yyout, "\tvpmax.s32 d%d, d%d, d%d\n", t, s, s + 1);
+            fprintf(yyout, "\tvpmax.s32 d%d, d%d, d%d\n", t, t, t);
+            break;
+        case VReduceMInstruction::VMIN:
+            fprintf(yyout, "\tvpmin.s32 d%d, d%d, d%d\n", t, s, s + 1);
+            fprintf(yyout, "\tvpmin.s32 d%d, d%d, d%d\n", t, t, t);
+            break;
+        default:
+            break;
+    }
+    fprintf(yyout, "\tvmov.32 ");
+    this->def_list[0]->output();
+    fprintf(yyout, ", d%d[0]\n", t);
+}
+
 MachineFunction::MachineFunction(MachineUnit* p, SymbolEntry* sym_ptr) 
 {
     this->parent = p;
@@ -452,6 +620,36 @@ MachineFunction::MachineFunction(MachineUnit* p, SymbolEntry* sym_ptr)
     this->paramsNum = ((FunctionType*)(sym_ptr->getType()))->getParamsSe().size();
 };
 
+MachineOperand* MachineFunction::paramOffset(int paramNo)
+{
+    MachineOperand* offset = new MachineOperand(MachineOperand::IMM, (paramNo - 4) * 4);
+    paramOffsets.push_back(offset);
+    return offset;
+}
+
+std::set<std::string> MachineFunction::getGlobals()
+{
+    std::set<std::string> globals;
+    for (auto block : block_list)
+        for (auto inst : block->getInsts())
+            for (auto operand : inst->getUse())
+                if (operand->isLabel() && operand->getLabel()[0] != '.' && operand->getLabel()[0] != '@')
+                    globals.insert(operand->getLabel());
+    return globals;
+}
+
+MachineOperand* MachineFunction::frameSize()
+{
+    unsigned size = AllocSpace(0);
+    // an immediate is eight bits rotated right by an even amount.
+    for (int rot = 0; rot < 32; rot += 2)
+        if (((size << rot) | (size >> ((32 - rot) % 32))) < 256)
+            return new MachineOperand(MachineOperand::IMM, size);
+    MachineOperand* ip = new MachineOperand(MachineOperand::REG, 12);
+    (new LoadMInstruction(nullptr, ip, new MachineOperand(MachineOperand::IMM, size)))->output();
+    return ip;
+}
+
 void MachineFunction::output() 
 {
     fprintf(yyout, "\t.global %s\n", this->sym_ptr->toStr().c_str() + 1);
@@ -470,8 +668,11 @@ void MachineFunction::output()
     MachineOperand *lr = new MachineOperand(MachineOperand::REG, 14);
     (new StackMInstrcuton(nullptr, StackMInstrcuton::PUSH, getSavedRegs(), fp, lr)) ->output();
     (new MovMInstruction(nullptr, MovMInstruction::MOV, fp, sp))->output();
+    // the arguments past the fourth sit right above the registers just pushed.
+    for (auto offset : paramOffsets)
+        offset->setVal(offset->getVal() + (saved_regs.size() + 2) * 4);
 
-    (new BinaryMInstruction(nullptr, BinaryMInstruction::SUB, sp, sp, new MachineOperand(MachineOperand::IMM, AllocSpace(0))))->output();
+    (new BinaryMInstruction(nullptr, BinaryMInstruction::SUB, sp, sp, frameSize()))->output();
     
     for (long unsigned int i = 0; i < block_list.size(); i++) 
     {
@@ -491,6 +692,42 @@ std::vector<MachineOperand*> MachineFunction::getSavedRegs()
     return regs;
 }
 
+/* An array is written as its non-zero elements with .zero for the gaps
+ * between them, and .fill for a run of equal elements. */
+void MachineUnit::PrintGlobalValue(IdentifierSymbolEntry* se) 
+{
+    if (!se->getType()->isArray()) 
+    {
+        fprintf(yyout, "\t.word %d\n", se->getValue());
+        return;
+    }
+    std::map<int, int>& value = se->getArrayValues();
+    int size = se->getType()->getSize() / 32;
+    int next = 0;
+    auto it = value.begin();
+    while (it != value.end()) 
+    {
+        if (it->first > next)
+            fprintf(yyout, "\t.zero %d\n", (it->first - next) * 4);
+        int count = 1;
+        auto run = std::next(it);
+        while (run != value.end() && run->first == it->first + count && run->second == it->second) 
+        {
+            count++;
+            run++;
+        }
+        if (count > 2)
+            fprintf(yyout, "\t.fill %d, 4, %d\n", count, it->second);
+        else
+            for (int i = 0; i < count; i++)
+                fprintf(yyout, "\t.word %d\n", it->second);
+        next = it->first + count;
+        it = run;
+    }
+    if (size > next)
+        fprintf(yyout, "\t.zero %d\n", (size - next) * 4);
+}
+
 void MachineUnit::PrintGlobalDecl() 
 {
     std::vector<int> constIdx;
@@ -513,7 +750,7 @@ void MachineUnit::PrintGlobalDecl()
             fprintf(yyout, ".global %s\n", se->toStr().c_str());
             fprintf(yyout, ".size %s, %d\n", se->toStr().c_str(), se->getType()->getSize() / 8);
             fprintf(yyout, "%s:\n", se->toStr().c_str());
-            fprintf(yyout, "\t.word %d\n", se->getValue());
+            PrintGlobalValue(se);
         }
     }
     if (zeroIdx.empty() == false) 
@@ -536,7 +773,7 @@ void MachineUnit::PrintGlobalDecl()
             fprintf(yyout, ".global %s\n", se->toStr().c_str());
             fprintf(yyout, ".size %s, %d\n", se->toStr().c_str(), se->getType()->getSize() / 8);
             fprintf(yyout, "%s:\n", se->toStr().c_str());
-            fprintf(yyout, "\t.word %d\n", se->getValue());
+            PrintGlobalValue(se);
         }
     }
 }
@@ -550,12 +787,17 @@ void MachineUnit::output()
      * 3. Don't forget print bridge label at the end of assembly code!! */
     fprintf(yyout, "\t.arch armv8-a\n");
     fprintf(yyout, "\t.arch_extension crc\n");
+    fprintf(yyout, "\t.fpu neon-fp-armv8\n");
     fprintf(yyout, "\t.arm\n");
     PrintGlobalDecl();
     fprintf(yyout, "\t.text\n");
+    // every function gets its own address pool, so the pool stays in reach of ldr.
     for (auto iter : func_list)
+    {
+        pool = iter->getGlobals();
         iter->output();
-    printGlobal();
+        printGlobal();
+    }
 }
 
 void MachineUnit::insertGlobal(SymbolEntry* se) 
@@ -563,14 +805,34 @@ void MachineUnit::insertGlobal(SymbolEntry* se)
     global_list.push_back(se);
 }
 
+void MachineUnit::removeGlobal(SymbolEntry* se) 
+{
+    global_list.erase(std::find(global_list.begin(), global_list.end(), se));
+}
+
 void MachineUnit::printGlobal()
 {
     for (auto s : global_list) {
         IdentifierSymbolEntry* se = (IdentifierSymbolEntry*)s;
+        if (!pool.count(se->toStr()))
+            continue;
         fprintf(yyout, "addr_%s%d:\n", se->toStr().c_str(), gnumber);
         fprintf(yyout, "\t.word %s\n", se->toStr().c_str());
     }
+    // the constants loaded with ldr =imm since the last pool go here too.
+    fprintf(yyout, "\t.ltorg\n");
     gnumber++;
+    sincePool = 0;
+}
+
+void MachineUnit::reachPool()
+{
+    if (++sincePool < 500)
+        return;
+    int no = gnumber;
+    fprintf(yyout, "\tb .LP%d\n", no);
+    printGlobal();
+    fprintf(yyout, ".LP%d:\n", no);
 }
 
 bool MachineOperand::operator==(const MachineOperand& a) const 
@@ -583,7 +845,7 @@ bool MachineOperand::operator==(const MachineOperand& a) const
     {
         return this->val == a.val;
     }
-    return this->reg_no == a.reg_no;
+    return this->vector == a.vector && this->reg_no == a.reg_no;
 }
 
 bool MachineOperand::operator<(const MachineOperand& a) const 
@@ -591,6 +853,8 @@ bool MachineOperand::operator<(const MachineOperand& a) const
     if (this->type == a.type) {
         if (this->type == IMM)
             return this->val < a.val;
+        if (this->vector != a.vector)
+            return a.vector;
         return this->reg_no < a.reg_no;
     }
     return this->type < a.type;
@@ -0,0 +1,255 @@
+#include "Memoizer.h"
+#include <algorithm>
+#include "Instruction.h"
+#include "MachineCode.h"
+#include "Type.h"
+#include "Unit.h"
+
+extern MachineUnit mUnit;
+
+/* A recursive function is pure when it takes one or two ints, returns an
+ * int, calls nothing but itself and only touches its own stack. Such a
+ * function first copies its arguments into key slots and looks them up: in
+ * a zeroed table of its own when every argument is small, in the runtime's
+ * hash table otherwise. A hit returns the cached value. Every return of the
+ * body goes through one exit block that records the result before
+ * returning it. Every value crossing a block is reloaded from a slot, so
+ * the check and exit blocks keep no register live between them. */
+
+Memoizer::Memoizer(Unit* unit)
+{
+    this->unit = unit;
+}
+
+void Memoizer::pass()
+{
+    int id = 0;
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        if (pure(*it))
+            memoize(*it, id++);
+}
+
+bool Memoizer::pure(Function* func)
+{
+    FunctionType* type = (FunctionType*)func->getSymPtr()->getType();
+    std::vector<Type*> params = type->getParamsType();
+    if (!type->getRetType()->isInt() || params.empty() || params.size() > 2)
+        return false;
+    for (auto param : params)
+        if (!param->isInt())
+            return false;
+    bool recursive = false;
+    for (auto bb : func->getBlockList())
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+        {
+            if (inst->isCall())
+            {
+                if (((CallInstruction*)inst)->getFuncSe() != func->getSymPtr())
+                    return false;
+                recursive = true;
+            }
+            if (inst->isRet() && inst->getOperands().empty())
+                return false;
+            if (!inst->isLoad() && !inst->isStore() && !inst->isVLoad() && !inst->isVStore())
+                continue;
+            // the address must lead back to an alloca of this function.
+            Operand* addr = inst->getOperands()[inst->isLoad() || inst->isVLoad() ? 1 : 0];
+            Instruction* def = addr->getDef();
+            while (def && def->isGep())
+                def = def->getOperands()[1]->getDef();
+            if (!def || !def->isAlloc())
+                return false;
+        }
+    return recursive;
+}
+
+Operand* Memoizer::table(const std::string& name)
+{
+    Type* type = new ArrayType(TypeSystem::intType, tableSize);
+    IdentifierSymbolEntry* se = new IdentifierSymbolEntry(type, name, globals->getLevel());
+    se->setAllZero();
+    SymbolEntry* addr_se = new IdentifierSymbolEntry(*se);
+    addr_se->setType(new PointerType(type));
+    se->setAddr(new Operand(addr_se));
+    unit->insertGlobal(se);
+    mUnit.insertGlobal(se);
+    return se->getAddr();
+}
+
+// the address of table[index].
+Operand* Memoizer::element(Operand* table, Operand* index, BasicBlock* bb)
+{
+    Operand* addr = Operand::temporary(new PointerType(TypeSystem::intType));
+    GepInstruction* gep = new GepInstruction(addr, table, index, bb);
+    gep->setFirst();
+    return addr;
+}
+
+BasicBlock* Memoizer::branch(int opcode, Operand* a, Operand* b, BasicBlock* bb, BasicBlock* t, BasicBlock* f)
+{
+    Operand* cond = Operand::temporary(TypeSystem::boolType);
+    new CmpInstruction(opcode, cond, a, b, bb);
+    new CondBrInstruction(t, f, cond, bb);
+    bb->addSucc(t);
+    t->addPred(bb);
+    bb->addSucc(f);
+    f->addPred(bb);
+    return bb;
+}
+
+void Memoizer::memoize(Function* func, int id)
+{
+    this->func = func;
+    BasicBlock* entry = func->getEntry();
+    std::string name = "__memo." + func->getSymPtr()->toStr().substr(1);
+    Operand* values = table(name + ".value");
+    Operand* known = table(name + ".known");
+    int n = ((FunctionType*)func->getSymPtr()->getType())->getParamsType().size();
+    int range = n == 1 ? tableSize : 64;
+    SymbolEntry* find = unit->declare("_sysy_memo_find", TypeSystem::intType, std::vector<Type*>(3, TypeSystem::intType));
+    SymbolEntry* value = unit->declare("_sysy_memo_value", TypeSystem::intType, {});
+    SymbolEntry* put = unit->declare("_sysy_memo_put", TypeSystem::voidType, std::vector<Type*>(4, TypeSystem::intType));
+
+    std::vector<Instruction*> paramStores;
+    std::vector<Operand*> params(n, nullptr);
+    for (auto inst = entry->begin(); inst != entry->end(); inst = inst->getNext())
+    {
+        SymbolEntry* se = inst->isStore() ? inst->getOperands()[1]->getEntry() : nullptr;
+        if (se && se->isVariable() && ((IdentifierSymbolEntry*)se)->isParam())
+        {
+            params[((IdentifierSymbolEntry*)se)->getParamNo()] = inst->getOperands()[0];
+            paramStores.push_back(inst);
+        }
+    }
+    if (std::find(params.begin(), params.end(), nullptr) != params.end())
+        return;
+    auto slot = [this, entry]() {
+        Operand* addr = Operand::temporary(new PointerType(TypeSystem::intType));
+        entry->insertFront(new AllocaInstruction(addr, new TemporarySymbolEntry(TypeSystem::intType, SymbolTable::getLabel())));
+        return addr;
+    };
+    std::vector<Operand*> keys;
+    for (int i = 0; i < n; i++)
+        keys.push_back(slot());
+    Operand* mode = slot();     // 1 for the table, 0 for the hash table
+    Operand* index = slot();
+    Operand* result = slot();
+    auto link = [](BasicBlock* from, BasicBlock* to) {
+        from->addSucc(to);
+        to->addPred(from);
+    };
+    auto load = [this](Operand* addr, BasicBlock* bb) {
+        Operand* dst = Operand::temporary(TypeSystem::intType);
+        new LoadInstruction(dst, addr, bb);
+        return dst;
+    };
+
+    // split the body off the entry, the rest of the entry saves the key.
+    std::vector<Instruction*> rets;
+    for (auto bb : func->getBlockList())
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            if (inst->isRet())
+                rets.push_back(inst);
+    BasicBlock* body = new BasicBlock(func);
+    std::vector<BasicBlock*>& list = func->getBlockList();
+    list.pop_back();
+    list.insert(std::find(list.begin(), list.end(), entry) + 1, body);
+    for (auto inst = entry->begin(); inst != entry->end();)
+    {
+        Instruction* next = inst->getNext();
+        if (!inst->isAlloc() && std::find(paramStores.begin(), paramStores.end(), inst) == paramStores.end())
+        {
+            entry->remove(inst);
+            body->insertBack(inst);
+        }
+        inst = next;
+    }
+    std::vector<BasicBlock*> succs(entry->succ_begin(), entry->succ_end());
+    for (auto succ : succs)
+    {
+        entry->removeSucc(succ);
+        succ->removePred(entry);
+        link(body, succ);
+    }
+    for (int i = 0; i < n; i++)
+        new StoreInstruction(keys[i], load(params[i], entry), entry);
+
+    // every argument in [0, range) looks in the table, anything else in the hash table.
+    size_t before = list.size();
+    std::vector<BasicBlock*> bounds;
+    for (int i = 0; i < 2 * n; i++)
+        bounds.push_back(new BasicBlock(func));
+    BasicBlock* inTable = new BasicBlock(func);
+    BasicBlock* tableHit = new BasicBlock(func);
+    BasicBlock* inHash = new BasicBlock(func);
+    BasicBlock* hashHit = new BasicBlock(func);
+    std::vector<BasicBlock*> checks(list.begin() + before, list.end());
+    list.erase(list.begin() + before, list.end());
+    list.insert(std::find(list.begin(), list.end(), body), checks.begin(), checks.end());
+    new UncondBrInstruction(bounds[0], entry);
+    link(entry, bounds[0]);
+    for (int i = 0; i < n; i++)
+    {
+        BasicBlock* next = i + 1 < n ? bounds[2 * i + 2] : inTable;
+        branch(CmpInstruction::GE, load(keys[i], bounds[2 * i]), Operand::constant(0), bounds[2 * i], bounds[2 * i + 1], inHash);
+        branch(CmpInstruction::L, load(keys[i], bounds[2 * i + 1]), Operand::constant(range), bounds[2 * i + 1], next, inHash);
+    }
+    Operand* idx = load(keys[0], inTable);
+    if (n == 2)
+    {
+        Operand* row = Operand::temporary(TypeSystem::intType);
+        Operand* sum = Operand::temporary(TypeSystem::intType);
+        new BinaryInstruction(BinaryInstruction::MUL, row, idx, Operand::constant(range), inTable);
+        new BinaryInstruction(BinaryInstruction::ADD, sum, row, load(keys[1], inTable), inTable);
+        idx = sum;
+    }
+    new StoreInstruction(index, idx, inTable);
+    new StoreInstruction(mode, Operand::constant(1), inTable);
+    branch(CmpInstruction::NE, load(element(known, idx, inTable), inTable), Operand::constant(0), inTable, tableHit, body);
+    new RetInstruction(load(element(values, load(index, tableHit), tableHit), tableHit), tableHit);
+
+    new StoreInstruction(mode, Operand::constant(0), inHash);
+    Operand* found = Operand::temporary(TypeSystem::intType);
+    new CallInstruction(found, find, {Operand::constant(id), load(keys[0], inHash), n == 2 ? load(keys[1], inHash) : Operand::constant(0)}, inHash);
+    branch(CmpInstruction::NE, found, Operand::constant(0), inHash, hashHit, body);
+    Operand* cached = Operand::temporary(TypeSystem::intType);
+    new CallInstruction(cached, value, {}, hashHit);
+    new RetInstruction(cached, hashHit);
+
+    // every return stores its value and leaves through the exit, which records it.
+    BasicBlock* exit = new BasicBlock(func);
+    BasicBlock* toTable = new BasicBlock(func);
+    BasicBlock* toHash = new BasicBlock(func);
+    BasicBlock* ret = new BasicBlock(func);
+    for (auto inst : rets)
+    {
+        BasicBlock* bb = inst->getParent();
+        bb->insertBefore(new StoreInstruction(result, inst->getOperands()[0]), inst);
+        for (auto i = inst; i != bb->end();)
+        {
+            Instruction* next = i->getNext();
+            bb->remove(i);
+            for (auto use : i->getUse())
+                use->removeUse(i);
+            i = next;
+        }
+        std::vector<BasicBlock*> succs(bb->succ_begin(), bb->succ_end());
+        for (auto succ : succs)
+        {
+            bb->removeSucc(succ);
+            succ->removePred(bb);
+        }
+        new UncondBrInstruction(exit, bb);
+        link(bb, exit);
+    }
+    branch(CmpInstruction::NE, load(mode, exit), Operand::constant(0), exit, toTable, toHash);
+    idx = load(index, toTable);
+    new StoreInstruction(element(known, idx, toTable), Operand::constant(1), toTable);
+    new StoreInstruction(element(values, idx, toTable), load(result, toTable), toTable);
+    new UncondBrInstruction(ret, toTable);
+    link(toTable, ret);
+    new CallInstruction(nullptr, put, {Operand::constant(id), load(keys[0], toHash), n == 2 ? load(keys[1], toHash) : Operand::constant(0), load(result, toHash)}, toHash);
+    new UncondBrInstruction(ret, toHash);
+    link(toHash, ret);
+    new RetInstruction(load(result, ret), ret);
+}
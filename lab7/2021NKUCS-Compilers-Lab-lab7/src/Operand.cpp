@@ -2,6 +2,7 @@
 #include <sstream>
 #include <algorithm>
 #include <string.h>
+#include "Type.h"
 
 std::string Operand::toStr() const
 {
@@ -15,3 +16,19 @@ void Operand::removeUse(Instruction *inst)
         uses.erase(i);
 }
 
+bool Operand::isGlobalInt()
+{
+    if (!se->isVariable() || !((IdentifierSymbolEntry*)se)->isGlobal() || !se->getType()->isPtr())
+        return false;
+    return ((PointerType*)se->getType())->getType()->isInt();
+}
+
+Operand* Operand::constant(int value)
+{
+    return new Operand(new ConstantSymbolEntry(TypeSystem::intType, value));
+}
+
+Operand* Operand::temporary(Type* type)
+{
+    return new Operand(new TemporarySymbolEntry(type, SymbolTable::getLabel()));
+}
@@ -0,0 +1,275 @@
+#include "PartialRedundancyElimination.h"
+#include <algorithm>
+#include <sstream>
+#include <vector>
+#include "AliasAnalysis.h"
+#include "Instruction.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* An arithmetic or address computation inside a loop whose operands all
+ * come from outside it is moved to a preheader, entered once before the
+ * loop, loops taken from the innermost out so it climbs as far as it can.
+ * So is a load of a scalar local or global no store or call in the loop may
+ * write. A division only moves from the header, which runs whenever the
+ * preheader did, as it would fault if run where the program never ran it.
+ * Then an expression computed on every path leaving a branch, anticipated
+ * in the usual dataflow sense, gets a copy before the branch once its
+ * operands are there. The copies down the paths are left to value
+ * numbering, which finds them dominated by it, so what was computed on some
+ * paths through a merge and again after it is computed once. */
+
+PartialRedundancyElimination::PartialRedundancyElimination(Unit* unit) : callGraph(unit)
+{
+    this->unit = unit;
+}
+
+void PartialRedundancyElimination::pass()
+{
+    callGraph.pass();
+    for (auto it = unit->begin(); it != unit->end(); it++)
+    {
+        func = *it;
+        analysis.pass(func);
+        std::vector<LoopAnalysis::Loop*> loops = analysis.getLoops();
+        for (auto loop : loops)
+            hoist(loop);
+        analysis.pass(func);
+        anticipate();
+    }
+}
+
+// what identifies the value inst computes, empty when it isn't moved.
+std::string PartialRedundancyElimination::key(Instruction* inst)
+{
+    std::vector<Operand*>& ops = inst->getOperands();
+    if ((!inst->isBinary() && !inst->isGep()) || inst->getDef()->getDef() != inst)
+        return "";
+    std::ostringstream buffer;
+    for (size_t i = 1; i < ops.size(); i++)
+        if (ops[i]->getEntry()->isConstant())
+            buffer << " #" << ((ConstantSymbolEntry*)ops[i]->getEntry())->getValue();
+        else
+            buffer << " " << ops[i];
+    if (inst->isBinary())
+        return "binary " + std::to_string(inst->getOpcode()) + buffer.str();
+    GepInstruction* gep = (GepInstruction*)inst;
+    if (gep->isFirst() && ops[2]->getEntry()->isConstant())
+        return "";
+    return "gep " + std::to_string(gep->isFirst()) + std::to_string(gep->isParamFirst()) + " " + ops[0]->getType()->toStr() + buffer.str();
+}
+
+// where code goes at the end of bb, before the branch and the compare it reads.
+Instruction* PartialRedundancyElimination::point(BasicBlock* bb)
+{
+    Instruction* inst = bb->rbegin();
+    if (inst->isCond() && inst->getPrev()->isCmp())
+        inst = inst->getPrev();
+    return inst;
+}
+
+// the block entering the loop from outside, made when there isn't a single one.
+BasicBlock* PartialRedundancyElimination::preheader(LoopAnalysis::Loop* loop)
+{
+    BasicBlock* header = loop->header;
+    std::vector<BasicBlock*> outside;
+    for (auto pred = header->pred_begin(); pred != header->pred_end(); pred++)
+        if (!loop->blocks.count(*pred) && std::find(outside.begin(), outside.end(), *pred) == outside.end())
+            outside.push_back(*pred);
+    if (outside.empty())
+        return nullptr;
+    if (outside.size() == 1 && outside[0]->getNumOfSucc() == 1)
+        return outside[0];
+    BasicBlock* pre = new BasicBlock(func);
+    std::vector<BasicBlock*>& list = func->getBlockList();
+    list.pop_back();
+    list.insert(std::find(list.begin(), list.end(), header), pre);
+    for (auto from : outside)
+    {
+        for (auto inst = from->begin(); inst != from->end(); inst = inst->getNext())
+            if (inst->isCond())
+            {
+                CondBrInstruction* br = (CondBrInstruction*)inst;
+                if (br->getTrueBranch() == header)
+                    br->setTrueBranch(pre);
+                if (br->getFalseBranch() == header)
+                    br->setFalseBranch(pre);
+            }
+            else if (inst->isUncond() && ((UncondBrInstruction*)inst)->getBranch() == header)
+                ((UncondBrInstruction*)inst)->setBranch(pre);
+        while (std::find(from->succ_begin(), from->succ_end(), header) != from->succ_end())
+        {
+            from->removeSucc(header);
+            header->removePred(from);
+            from->addSucc(pre);
+            pre->addPred(from);
+        }
+    }
+    new UncondBrInstruction(header, pre);
+    pre->addSucc(header);
+    header->addPred(pre);
+    // the enclosing loops hold it now.
+    for (auto parent = loop->parent; parent; parent = parent->parent)
+        parent->blocks.insert(pre);
+    return pre;
+}
+
+bool PartialRedundancyElimination::invariant(LoopAnalysis::Loop* loop, Operand* op)
+{
+    if (!op->getEntry()->isTemporary())
+        return true;
+    return op->getDef() && !loop->blocks.count(op->getDef()->getParent());
+}
+
+// whether inst computes the same on every iteration and may run once before the loop instead.
+bool PartialRedundancyElimination::movable(LoopAnalysis::Loop* loop, Instruction* inst, std::vector<Instruction*>& writes)
+{
+    std::vector<Operand*> uses = inst->getUse();
+    for (auto use : uses)
+        if (!invariant(loop, use))
+            return false;
+    unsigned op = inst->getOpcode();
+    if (inst->isBinary() && (op == BinaryInstruction::DIV || op == BinaryInstruction::MOD))
+        return inst->getParent() == loop->header;
+    if (!inst->isLoad())
+        return !key(inst).empty();
+    // a scalar local or global, always there to read, that nothing in the loop writes.
+    Operand* addr = uses[0];
+    AliasAnalysis::Location loc = AliasAnalysis::locate(addr);
+    if (inst->getDef()->getDef() != inst || loc.base != addr || (loc.kind != AliasAnalysis::LOCAL && loc.kind != AliasAnalysis::GLOBAL))
+        return false;
+    if (((PointerType*)addr->getType())->getType()->isArray())
+        return false;
+    for (auto write : writes)
+        if ((write->isStore() && AliasAnalysis::mayAlias(write->getOperands()[0], addr)) || write->isVStore() || (write->isCall() && callGraph.mayAccess(write, addr)))
+            return false;
+    return true;
+}
+
+void PartialRedundancyElimination::hoist(LoopAnalysis::Loop* loop)
+{
+    std::vector<BasicBlock*> blocks;
+    for (auto bb : func->getBlockList())
+        if (loop->blocks.count(bb))
+            blocks.push_back(bb);
+    std::vector<Instruction*> writes;
+    for (auto bb : blocks)
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            if (inst->isStore() || inst->isVStore() || inst->isCall())
+                writes.push_back(inst);
+    BasicBlock* pre = nullptr;
+    bool change = true;
+    while (change)
+    {
+        change = false;
+        for (auto bb : blocks)
+            for (auto inst = bb->begin(); inst != bb->end();)
+            {
+                Instruction* next = inst->getNext();
+                bool movable = this->movable(loop, inst, writes);
+                if (movable && !pre)
+                    pre = preheader(loop);
+                if (movable && pre)
+                {
+                    bb->remove(inst);
+                    pre->insertBefore(inst, pre->rbegin());
+                    change = true;
+                }
+                inst = next;
+            }
+    }
+}
+
+void PartialRedundancyElimination::anticipate()
+{
+    std::vector<BasicBlock*>& order = analysis.getOrder();
+    std::map<std::string, Instruction*> any;                 // an instance of every expression
+    std::map<BasicBlock*, std::set<std::string>> exposed;    // computed from operands defined before the block
+    std::map<BasicBlock*, std::set<std::string>> computed;
+    std::map<BasicBlock*, std::set<Operand*>> defined;
+    for (auto bb : order)
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+        {
+            if (inst->getDef())
+                defined[bb].insert(inst->getDef());
+            std::string k = key(inst);
+            if (k.empty())
+                continue;
+            any.insert({k, inst});
+            computed[bb].insert(k);
+            bool upward = true;
+            for (auto use : inst->getUse())
+                if (defined[bb].count(use))
+                    upward = false;
+            if (upward)
+                exposed[bb].insert(k);
+        }
+    std::set<std::string> all;
+    for (auto& it : any)
+        all.insert(it.first);
+    // the expressions every path from a block's start or end computes before changing their operands.
+    std::map<BasicBlock*, std::set<std::string>> in, out;
+    for (auto bb : order)
+        in[bb] = all;
+    bool change = true;
+    while (change)
+    {
+        change = false;
+        for (auto it = order.rbegin(); it != order.rend(); it++)
+        {
+            BasicBlock* bb = *it;
+            std::set<std::string> o;
+            bool first = true;
+            for (auto succ = bb->succ_begin(); succ != bb->succ_end(); succ++)
+            {
+                if (first)
+                    o = in[*succ];
+                else
+                {
+                    std::set<std::string> temp;
+                    std::set_intersection(o.begin(), o.end(), in[*succ].begin(), in[*succ].end(), std::inserter(temp, temp.end()));
+                    o = temp;
+                }
+                first = false;
+            }
+            std::set<std::string> i = exposed[bb];
+            for (auto& k : o)
+            {
+                bool kept = true;
+                for (auto use : any[k]->getUse())
+                    if (defined[bb].count(use))
+                        kept = false;
+                if (kept)
+                    i.insert(k);
+            }
+            if (i != in[bb])
+                change = true;
+            in[bb] = i;
+            out[bb] = o;
+        }
+    }
+    for (auto bb : order)
+    {
+        std::set<BasicBlock*> succs(bb->succ_begin(), bb->succ_end());
+        if (succs.size() < 2)
+            continue;
+        for (auto& k : out[bb])
+        {
+            Instruction* inst = any[k];
+            bool ready = true;
+            for (auto use : inst->getUse())
+                if (use->getEntry()->isTemporary() && (!use->getDef() || !analysis.dominates(use->getDef()->getParent(), bb)))
+                    ready = false;
+            // already there, value numbering takes care of the rest.
+            for (BasicBlock* dom = bb; dom && ready; dom = analysis.idom(dom))
+                if (computed[dom].count(k))
+                    ready = false;
+            if (!ready)
+                continue;
+            Instruction* copy = inst->copy();
+            copy->replaceDef(Operand::temporary(inst->getDef()->getType()));
+            bb->insertBefore(copy, point(bb));
+            computed[bb].insert(k);
+        }
+    }
+}
@@ -0,0 +1,294 @@
+#include "SLPVectorizer.h"
+#include <algorithm>
+#include "AliasAnalysis.h"
+#include "Instruction.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* Stores to a[k], a[k + 1], a[k + 2] and a[k + 3] in one block become a
+ * single vst1 through the address of a[k]. The stored values are packed
+ * bottom up: the same value in every lane is broadcast, loads of four
+ * adjacent elements become a vld1, the same add, sub or mul in every lane
+ * becomes a vector operation, anything else is gathered lane by lane. The
+ * pack is placed at the last of the four stores, so nothing in between may
+ * read the stored elements or write the loaded ones. Every element address
+ * costs a gep of its own, so even a gathered pack is shorter than the four
+ * stores it replaces. */
+
+SLPVectorizer::SLPVectorizer(Unit* unit) : callGraph(unit)
+{
+    this->unit = unit;
+}
+
+void SLPVectorizer::pass()
+{
+    callGraph.pass();
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        for (auto bb : (*it)->getBlockList())
+            pass(bb);
+}
+
+void SLPVectorizer::pass(BasicBlock* bb)
+{
+    this->bb = bb;
+    position.clear();
+    int no = 0;
+    for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+        position[inst] = no++;
+    // the element stores of every array, sorted by index.
+    std::vector<Operand*> bases;
+    std::vector<std::vector<std::pair<int, Instruction*>>> groups;
+    for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+    {
+        Operand* base;
+        int index;
+        if (!inst->isStore() || !element(inst->getOperands()[0], base, index))
+            continue;
+        size_t i = 0;
+        while (i < bases.size() && !sameValue(bases[i], base))
+            i++;
+        if (i == bases.size())
+        {
+            bases.push_back(base);
+            groups.push_back(std::vector<std::pair<int, Instruction*>>());
+        }
+        groups[i].push_back({index, inst});
+    }
+    for (auto& group : groups)
+    {
+        std::stable_sort(group.begin(), group.end(), [](const std::pair<int, Instruction*>& a, const std::pair<int, Instruction*>& b) {
+            return a.first < b.first;
+        });
+        size_t i = 0;
+        while (i + width <= group.size())
+        {
+            std::vector<Instruction*> stores;
+            for (int j = 0; j < width; j++)
+                if (group[i + j].first == group[i].first + j)
+                    stores.push_back(group[i + j].second);
+            if (stores.size() == width && pack(stores))
+                i += width;
+            else
+                i++;
+        }
+    }
+}
+
+// &base[index] with a constant index into an int array.
+bool SLPVectorizer::element(Operand* addr, Operand*& base, int& index)
+{
+    Instruction* def = addr->getDef();
+    if (!def || !def->isGep() || !def->getOperands()[2]->getEntry()->isConstant())
+        return false;
+    if (!((PointerType*)addr->getType())->getType()->isInt())
+        return false;
+    base = def->getOperands()[1];
+    index = ((ConstantSymbolEntry*)def->getOperands()[2]->getEntry())->getValue();
+    return true;
+}
+
+// whether two operands of the block hold the same value wherever both are defined.
+bool SLPVectorizer::sameValue(Operand* a, Operand* b)
+{
+    if (a == b)
+        return true;
+    if (a->getEntry()->isConstant() && b->getEntry()->isConstant())
+        return ((ConstantSymbolEntry*)a->getEntry())->getValue() == ((ConstantSymbolEntry*)b->getEntry())->getValue();
+    Instruction* da = a->getDef();
+    Instruction* db = b->getDef();
+    if (!da || !db || da->getParent() != bb || db->getParent() != bb)
+        return false;
+    if (da->isLoad() && db->isLoad())
+    {
+        // a scalar variable that is not written between the two loads.
+        Operand* addr = da->getOperands()[1];
+        if (addr != db->getOperands()[1] || (addr->getDef() && addr->getDef()->isGep()))
+            return false;
+        if (position[da] > position[db])
+            std::swap(da, db);
+        return !clobbered(da, db, addr, false);
+    }
+    if ((da->isGep() && db->isGep()) || (da->isBinary() && db->isBinary() && da->getOpcode() == db->getOpcode()))
+        return sameValue(da->getOperands()[1], db->getOperands()[1]) && sameValue(da->getOperands()[2], db->getOperands()[2]);
+    return false;
+}
+
+/* Whether na ints from a overlap nb ints from b. Elements of one array
+ * overlap when their indices do, distinct local and global arrays never do,
+ * and a parameter can't point into our own frame. */
+bool SLPVectorizer::mayAlias(Operand* a, int na, Operand* b, int nb)
+{
+    Operand *base1, *base2;
+    int ia, ib;
+    if (element(a, base1, ia) && element(b, base2, ib) && sameValue(base1, base2))
+        return ia < ib + nb && ib < ia + na;
+    bool pa, pb;
+    Operand* ra = AliasAnalysis::root(a, pa);
+    Operand* rb = AliasAnalysis::root(b, pb);
+    if (ra == rb)
+        return true;
+    if (!pa && !pb)
+        return false;
+    if (pa && pb)
+        return true;
+    return !(pa ? rb : ra)->getDef();
+}
+
+// whether an instruction strictly between from and to may write the int at addr, or read it too when reads is set.
+bool SLPVectorizer::clobbered(Instruction* from, Instruction* to, Operand* addr, bool reads)
+{
+    if (from == to)
+        return false;
+    for (auto inst = from->getNext(); inst != to; inst = inst->getNext())
+    {
+        if (inst->isCall() && callGraph.mayAccess(inst, addr, reads))
+            return true;
+        if ((inst->isStore() || inst->isVStore()) && mayAlias(inst->getOperands()[0], inst->isStore() ? 1 : width, addr, 1))
+            return true;
+        if (reads && (inst->isLoad() || inst->isVLoad()) && mayAlias(inst->getOperands()[1], inst->isLoad() ? 1 : width, addr, 1))
+            return true;
+    }
+    return false;
+}
+
+int SLPVectorizer::kindOf(std::vector<Operand*>& lanes)
+{
+    bool same = true, adjacent = true, isomorphic = true;
+    Operand* base0 = nullptr;
+    int index0 = 0;
+    Instruction* def0 = lanes[0]->getDef();
+    for (int j = 0; j < width; j++)
+    {
+        if (!sameValue(lanes[j], lanes[0]))
+            same = false;
+        Instruction* def = lanes[j]->getDef();
+        if (!def || !def0 || def->getParent() != bb)
+        {
+            adjacent = isomorphic = false;
+            continue;
+        }
+        Operand* base;
+        int index;
+        if (!def->isLoad() || !element(def->getOperands()[1], base, index))
+            adjacent = false;
+        else if (j == 0)
+        {
+            base0 = base;
+            index0 = index;
+        }
+        else if (!base0 || !sameValue(base, base0) || index != index0 + j)
+            adjacent = false;
+        unsigned opcode = def->getOpcode();
+        if (!def->isBinary() || !def0->isBinary() || opcode != def0->getOpcode() || lanes[j]->usersNum() != 1
+            || (opcode != BinaryInstruction::ADD && opcode != BinaryInstruction::SUB && opcode != BinaryInstruction::MUL))
+            isomorphic = false;
+    }
+    if (same)
+        return DUP;
+    if (adjacent)
+        return LOAD;
+    if (isomorphic)
+        return BINARY;
+    return BUILD;
+}
+
+// remember the loads a pack reads memory through.
+void SLPVectorizer::collect(std::vector<Operand*> lanes)
+{
+    int kind = kindOf(lanes);
+    if (kind == LOAD)
+        for (auto lane : lanes)
+            loads.push_back(lane->getDef());
+    if (kind == BINARY)
+    {
+        for (int k = 1; k <= 2; k++)
+        {
+            std::vector<Operand*> ops;
+            for (auto lane : lanes)
+                ops.push_back(lane->getDef()->getOperands()[k]);
+            collect(ops);
+        }
+    }
+}
+
+Operand* SLPVectorizer::emit(std::vector<Operand*> lanes, Instruction* pos)
+{
+    Operand* dst = Operand::temporary(TypeSystem::vectorIntType);
+    Instruction* inst = nullptr;
+    switch (kindOf(lanes))
+    {
+        case DUP:
+            inst = new VDupInstruction(dst, lanes[0]);
+            break;
+        case LOAD:
+            inst = new VLoadInstruction(dst, lanes[0]->getDef()->getOperands()[1]);
+            break;
+        case BINARY:
+        {
+            std::vector<Operand*> lhs, rhs;
+            for (auto lane : lanes)
+            {
+                lhs.push_back(lane->getDef()->getOperands()[1]);
+                rhs.push_back(lane->getDef()->getOperands()[2]);
+            }
+            unsigned opcode = lanes[0]->getDef()->getOpcode();
+            if (opcode == BinaryInstruction::ADD)
+                opcode = VBinaryInstruction::ADD;
+            else if (opcode == BinaryInstruction::SUB)
+                opcode = VBinaryInstruction::SUB;
+            else
+                opcode = VBinaryInstruction::MUL;
+            Operand* src1 = emit(lhs, pos);
+            Operand* src2 = emit(rhs, pos);
+            inst = new VBinaryInstruction(opcode, dst, src1, src2);
+            break;
+        }
+        default:
+            inst = new VBuildInstruction(dst, lanes);
+            break;
+    }
+    bb->insertBefore(inst, pos);
+    return dst;
+}
+
+// remove an instruction, and what only computed its operands.
+void SLPVectorizer::erase(Instruction* inst)
+{
+    bb->remove(inst);
+    for (auto use : inst->getUse())
+    {
+        use->removeUse(inst);
+        Instruction* def = use->getDef();
+        if (def && def->getParent() == bb && use->usersNum() == 0 && (def->isLoad() || def->isGep() || def->isBinary()))
+            erase(def);
+    }
+}
+
+bool SLPVectorizer::pack(std::vector<Instruction*>& stores)
+{
+    position.clear();
+    int no = 0;
+    for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+        position[inst] = no++;
+    Instruction* last = stores[0];
+    std::vector<Operand*> values;
+    for (auto store : stores)
+    {
+        if (position[store] > position[last])
+            last = store;
+        values.push_back(store->getOperands()[1]);
+    }
+    loads.clear();
+    collect(values);
+    for (auto store : stores)
+        if (clobbered(store, last, store->getOperands()[0], true))
+            return false;
+    for (auto load : loads)
+        if (clobbered(load, last, load->getOperands()[1], false))
+            return false;
+    Operand* vec = emit(values, last);
+    bb->insertBefore(new VStoreInstruction(stores[0]->getOperands()[0], vec), last);
+    for (auto store : stores)
+        erase(store);
+    return true;
+}
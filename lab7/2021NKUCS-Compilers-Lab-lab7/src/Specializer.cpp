@@ -0,0 +1,195 @@
+#include "Specializer.h"
+#include <algorithm>
+#include <string>
+#include "Instruction.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* The calls of a function are grouped by the constants they pass to its int
+ * parameters, counting only parameters whose stack slot is never written
+ * again after the entry. The largest groups get a copy of the function of
+ * their own, named after it with a number, while the copies stay within a
+ * budget. In a copy the loads of those slots become the constants, and
+ * constant propagation carries them through the copy, turning the branches
+ * they decide into jumps and dropping the blocks no longer reached. A call
+ * of the function inside a copy passing the same constants goes to the
+ * copy itself. The copies keep the parameters of the function, so the
+ * calls are only redirected. */
+
+Specializer::Specializer(Unit* unit) : constantPropagation(unit)
+{
+    this->unit = unit;
+}
+
+void Specializer::pass()
+{
+    std::vector<Function*> funcs(unit->begin(), unit->end());
+    std::map<SymbolEntry*, Function*> functions;
+    for (auto func : funcs)
+        functions[func->getSymPtr()] = func;
+    std::map<Function*, std::vector<Instruction*>> calls;
+    for (auto func : funcs)
+        for (auto bb : func->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+                if (inst->isCall() && functions.count(((CallInstruction*)inst)->getFuncSe()))
+                    calls[functions[((CallInstruction*)inst)->getFuncSe()]].push_back(inst);
+    int growth = 0;
+    for (auto func : funcs)
+    {
+        int n = size(func);
+        if (func->getSymPtr()->toStr() == "@main" || calls[func].empty() || n > maxSize)
+            continue;
+        std::map<int, Operand*> params = slots(func);
+        if (params.empty())
+            continue;
+        std::map<Signature, std::vector<Instruction*>> groups;
+        for (auto call : calls[func])
+        {
+            Signature sig = signature(call, params);
+            if (!sig.empty())
+                groups[sig].push_back(call);
+        }
+        std::vector<std::pair<Signature, std::vector<Instruction*>>> order(groups.begin(), groups.end());
+        std::stable_sort(order.begin(), order.end(), [](const std::pair<Signature, std::vector<Instruction*>>& a, const std::pair<Signature, std::vector<Instruction*>>& b) {
+            return a.second.size() > b.second.size();
+        });
+        int id = 0;
+        for (auto& group : order)
+        {
+            if (id == maxClones || growth + n > maxGrowth)
+                break;
+            Function* copy = clone(func, group.first, params, id++);
+            growth += n;
+            for (auto call : group.second)
+                ((CallInstruction*)call)->setFuncSe(copy->getSymPtr());
+            for (auto bb : copy->getBlockList())
+                for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+                    if (inst->isCall() && ((CallInstruction*)inst)->getFuncSe() == func->getSymPtr() && signature(inst, params) == group.first)
+                        ((CallInstruction*)inst)->setFuncSe(copy->getSymPtr());
+        }
+    }
+}
+
+int Specializer::size(Function* func)
+{
+    int n = 0;
+    for (auto bb : func->getBlockList())
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            n++;
+    return n;
+}
+
+// the slot of every int parameter that is only stored on entry and loaded after.
+std::map<int, Operand*> Specializer::slots(Function* func)
+{
+    std::map<int, Operand*> params;
+    BasicBlock* entry = func->getEntry();
+    for (auto inst = entry->begin(); inst != entry->end(); inst = inst->getNext())
+    {
+        if (!inst->isStore())
+            continue;
+        SymbolEntry* se = inst->getOperands()[1]->getEntry();
+        if (!se->isVariable() || !((IdentifierSymbolEntry*)se)->isParam() || !se->getType()->isInt())
+            continue;
+        Operand* slot = inst->getOperands()[0];
+        if (!slot->getDef() || !slot->getDef()->isAlloc())
+            continue;
+        bool loaded = true;
+        for (auto use = slot->use_begin(); use != slot->use_end(); use++)
+            if (*use != inst && (!(*use)->isLoad() || (*use)->getOperands()[1] != slot))
+                loaded = false;
+        if (loaded)
+            params[((IdentifierSymbolEntry*)se)->getParamNo()] = slot;
+    }
+    return params;
+}
+
+// the constants a call passes to the parameters in slots.
+Specializer::Signature Specializer::signature(Instruction* call, std::map<int, Operand*>& slots)
+{
+    Signature sig;
+    std::vector<Operand*>& args = call->getOperands();
+    for (auto& param : slots)
+    {
+        if (param.first + 1 >= (int)args.size())
+            continue;
+        SymbolEntry* se = args[param.first + 1]->getEntry();
+        if (se->isConstant() && se->getType()->isInt())
+            sig.push_back({param.first, ((ConstantSymbolEntry*)se)->getValue()});
+    }
+    return sig;
+}
+
+Operand* Specializer::remap(Operand* op)
+{
+    if (operands.count(op))
+        return operands[op];
+    SymbolEntry* se = op->getEntry();
+    Operand* rep = op;
+    if (se->isTemporary())
+        rep = Operand::temporary(se->getType());
+    operands[op] = rep;
+    return rep;
+}
+
+Function* Specializer::clone(Function* func, const Signature& sig, std::map<int, Operand*>& slots, int id)
+{
+    operands.clear();
+    SymbolEntry* se = func->getSymPtr();
+    std::string name = se->toStr().substr(1) + "." + std::to_string(id);
+    Function* copy = new Function(unit, new IdentifierSymbolEntry(se->getType(), name, globals->getLevel()));
+    unit->removeFunc(copy);
+    unit->insertFunc(copy, func);
+
+    std::map<BasicBlock*, BasicBlock*> copies;
+    for (auto bb : func->getBlockList())
+        copies[bb] = bb == func->getEntry() ? copy->getEntry() : new BasicBlock(copy);
+    for (auto bb : func->getBlockList())
+    {
+        BasicBlock* to = copies[bb];
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+        {
+            Instruction* c = inst->copy();
+            for (auto use : c->getUse())
+                c->replaceUse(use, remap(use));
+            if (c->getDef())
+                c->replaceDef(remap(c->getDef()));
+            if (c->isCond())
+            {
+                CondBrInstruction* br = (CondBrInstruction*)c;
+                br->setTrueBranch(copies[br->getTrueBranch()]);
+                br->setFalseBranch(copies[br->getFalseBranch()]);
+            }
+            else if (c->isUncond())
+                ((UncondBrInstruction*)c)->setBranch(copies[((UncondBrInstruction*)c)->getBranch()]);
+            to->insertBack(c);
+        }
+        for (auto succ = bb->succ_begin(); succ != bb->succ_end(); succ++)
+            to->addSucc(copies[*succ]);
+        for (auto pred = bb->pred_begin(); pred != bb->pred_end(); pred++)
+            to->addPred(copies[*pred]);
+    }
+
+    // the parameters are the constants, their slots go away.
+    for (auto& param : sig)
+    {
+        Operand* slot = operands[slots[param.first]];
+        std::vector<Instruction*> users(slot->use_begin(), slot->use_end());
+        for (auto user : users)
+        {
+            if (user->isLoad())
+                replaceAll(user->getDef(), Operand::constant(param.second));
+            user->getParent()->erase(user);
+        }
+        slot->getDef()->getParent()->erase(slot->getDef());
+    }
+    constantPropagation.propagate(copy);
+    return copy;
+}
+
+void Specializer::replaceAll(Operand* old, Operand* rep)
+{
+    std::vector<Instruction*> users(old->use_begin(), old->use_end());
+    for (auto user : users)
+        user->replaceUse(old, rep);
+}
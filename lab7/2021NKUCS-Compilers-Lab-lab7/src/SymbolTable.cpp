@@ -74,6 +74,7 @@ IdentifierSymbolEntry::IdentifierSymbolEntry(Type* type,
       paramNo(paramNo) {
     this->scope = scope;
     this->initial = false;
+    this->value = 0;
     this->label = -1;
     this->allZero = false;
     this->constant = false;
@@ -92,17 +93,16 @@ void IdentifierSymbolEntry::setValue(int value) {
     }
 }
 
-void IdentifierSymbolEntry::setArrayValue(int* arrayValue) {
-    if (((IntType*)(this->getType()))->isConst()) {
-        if (!initial) {
-            this->arrayValue = arrayValue;
-            initial = true;
-        } else {
-            // 需要报错
-        }
-    } else {
-        this->arrayValue = arrayValue;
-    }
+void IdentifierSymbolEntry::setArrayValue(int index, int value) {
+    if (value != 0)
+        arrayValue[index] = value;
+    else
+        arrayValue.erase(index);
+}
+
+int IdentifierSymbolEntry::getArrayValue(int index) const {
+    auto it = arrayValue.find(index);
+    return it == arrayValue.end() ? 0 : it->second;
 }
 
 std::string IdentifierSymbolEntry::toStr() {
@@ -0,0 +1,181 @@
+#include "TailRecursion.h"
+#include <algorithm>
+#include <set>
+#include "Instruction.h"
+#include "Type.h"
+#include "Unit.h"
+
+/* A call of the function itself whose result is returned right away stores
+ * its arguments into the stack slots of the parameters and branches back to
+ * the body, which is split off the entry so the allocas and the stores of
+ * the incoming parameters run once. A call whose result is only added to or
+ * multiplied by a value computed before it and then returned is handled the
+ * same way through an accumulator: the value is folded into the accumulator
+ * before the branch, and every other return folds the accumulator into its
+ * result. */
+
+TailRecursion::TailRecursion(Unit* unit)
+{
+    this->unit = unit;
+}
+
+void TailRecursion::pass()
+{
+    for (auto it = unit->begin(); it != unit->end(); it++)
+        pass(*it);
+}
+
+// whether call is a self call whose result is returned, op is set to the add or mul between the two.
+bool TailRecursion::tailCall(Instruction* call, Instruction*& op)
+{
+    op = nullptr;
+    if (((CallInstruction*)call)->getFuncSe() != func->getSymPtr())
+        return false;
+    Operand* def = call->getDef();
+    Instruction* next = call->getNext();
+    if (next->isRet())
+        return next->getOperands().empty() || next->getOperands()[0] == def;
+    if (next->isUncond())
+    {
+        Instruction* ret = ((UncondBrInstruction*)next)->getBranch()->begin();
+        return ret->isRet() && ret->getOperands().empty();
+    }
+    if (!def || !next->isBinary() || def->usersNum() != 1)
+        return false;
+    if (next->getOpcode() != BinaryInstruction::ADD && next->getOpcode() != BinaryInstruction::MUL)
+        return false;
+    if ((next->getOperands()[1] == def) == (next->getOperands()[2] == def))
+        return false;
+    Instruction* ret = next->getNext();
+    if (!ret->isRet() || ret->getOperands().empty() || ret->getOperands()[0] != next->getDef() || next->getDef()->usersNum() != 1)
+        return false;
+    op = next;
+    return true;
+}
+
+void TailRecursion::pass(Function* func)
+{
+    this->func = func;
+    std::vector<std::pair<Instruction*, Instruction*>> sites;
+    int opcode = -1;
+    for (auto bb : func->getBlockList())
+        for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+        {
+            Instruction* op;
+            if (!inst->isCall() || !tailCall(inst, op))
+                continue;
+            if (op && opcode != -1 && (int)op->getOpcode() != opcode)
+                continue;
+            if (op)
+                opcode = op->getOpcode();
+            sites.push_back({inst, op});
+        }
+    if (sites.empty())
+        return;
+
+    // the stack slot every parameter is stored to on entry.
+    BasicBlock* entry = func->getEntry();
+    std::vector<Instruction*> paramStores;
+    std::vector<Operand*> slots(sites[0].first->getOperands().size() - 1, nullptr);
+    for (auto inst = entry->begin(); inst != entry->end(); inst = inst->getNext())
+    {
+        if (!inst->isStore())
+            continue;
+        SymbolEntry* se = inst->getOperands()[1]->getEntry();
+        if (!se->isVariable() || !((IdentifierSymbolEntry*)se)->isParam())
+            continue;
+        int no = ((IdentifierSymbolEntry*)se)->getParamNo();
+        if (no < (int)slots.size())
+            slots[no] = inst->getOperands()[0];
+        paramStores.push_back(inst);
+    }
+    if (std::find(slots.begin(), slots.end(), nullptr) != slots.end())
+        return;
+
+    auto link = [](BasicBlock* from, BasicBlock* to) {
+        from->addSucc(to);
+        to->addPred(from);
+    };
+    BasicBlock* body = new BasicBlock(func);
+    std::vector<BasicBlock*>& list = func->getBlockList();
+    list.pop_back();
+    list.insert(std::find(list.begin(), list.end(), entry) + 1, body);
+    for (auto inst = entry->begin(); inst != entry->end();)
+    {
+        Instruction* next = inst->getNext();
+        if (!inst->isAlloc() && std::find(paramStores.begin(), paramStores.end(), inst) == paramStores.end())
+        {
+            entry->remove(inst);
+            body->insertBack(inst);
+        }
+        inst = next;
+    }
+    std::vector<BasicBlock*> succs(entry->succ_begin(), entry->succ_end());
+    for (auto succ : succs)
+    {
+        entry->removeSucc(succ);
+        succ->removePred(entry);
+        link(body, succ);
+    }
+    new UncondBrInstruction(body, entry);
+    link(entry, body);
+
+    Operand* acc = nullptr;
+    if (opcode != -1)
+    {
+        acc = Operand::temporary(new PointerType(TypeSystem::intType));
+        entry->insertFront(new AllocaInstruction(acc, new TemporarySymbolEntry(TypeSystem::intType, SymbolTable::getLabel())));
+        int identity = opcode == BinaryInstruction::ADD ? 0 : 1;
+        entry->insertBefore(new StoreInstruction(acc, Operand::constant(identity)), entry->rbegin());
+        // every return that is not a tail call folds the accumulator into its result.
+        std::set<Instruction*> tails;
+        for (auto& site : sites)
+            tails.insert((site.second ? site.second : site.first)->getNext());
+        for (auto bb : func->getBlockList())
+            for (auto inst = bb->begin(); inst != bb->end(); inst = inst->getNext())
+            {
+                if (!inst->isRet() || inst->getOperands().empty() || tails.count(inst))
+                    continue;
+                Operand* value = inst->getOperands()[0];
+                Operand* sofar = Operand::temporary(TypeSystem::intType);
+                Operand* result = Operand::temporary(TypeSystem::intType);
+                bb->insertBefore(new LoadInstruction(sofar, acc), inst);
+                bb->insertBefore(new BinaryInstruction(opcode, result, sofar, value), inst);
+                inst->replaceUse(value, result);
+            }
+    }
+
+    for (auto& site : sites)
+    {
+        Instruction* call = site.first;
+        BasicBlock* bb = call->getParent();
+        std::vector<Operand*> args(call->getOperands().begin() + 1, call->getOperands().end());
+        for (size_t i = 0; i < args.size(); i++)
+            bb->insertBefore(new StoreInstruction(slots[i], args[i]), call);
+        if (site.second)
+        {
+            Operand* def = call->getDef();
+            Operand* value = site.second->getOperands()[1] == def ? site.second->getOperands()[2] : site.second->getOperands()[1];
+            Operand* sofar = Operand::temporary(TypeSystem::intType);
+            Operand* result = Operand::temporary(TypeSystem::intType);
+            bb->insertBefore(new LoadInstruction(sofar, acc), call);
+            bb->insertBefore(new BinaryInstruction(opcode, result, sofar, value), call);
+            bb->insertBefore(new StoreInstruction(acc, result), call);
+        }
+        // the call, the return and whatever was left after it.
+        for (auto inst = call; inst != bb->end();)
+        {
+            Instruction* next = inst->getNext();
+            inst->getParent()->erase(inst);
+            inst = next;
+        }
+        std::vector<BasicBlock*> succs(bb->succ_begin(), bb->succ_end());
+        for (auto succ : succs)
+        {
+            bb->removeSucc(succ);
+            succ->removePred(bb);
+        }
+        new UncondBrInstruction(body, bb);
+        link(bb, body);
+    }
+}
@@ -7,11 +7,13 @@ IntType TypeSystem::commonConstInt = IntType(32, true);
 IntType TypeSystem::commonInt = IntType(32);
 IntType TypeSystem::commonBool = IntType(1);
 VoidType TypeSystem::commonVoid = VoidType();
+VectorType TypeSystem::commonVectorInt = VectorType(&commonInt, 4);
 
 Type* TypeSystem::constIntType = &commonConstInt;
 Type* TypeSystem::intType = &commonInt;
 Type* TypeSystem::voidType = &commonVoid;
 Type* TypeSystem::boolType = &commonBool;
+Type* TypeSystem::vectorIntType = &commonVectorInt;
 
 std::string IntType::toStr() {
     std::ostringstream buffer;
@@ -78,3 +80,9 @@ std::string PointerType::toStr() {
     buffer << valueType->toStr() << "*";
     return buffer.str();
 }
+
+std::string VectorType::toStr() {
+    std::ostringstream buffer;
+    buffer << "<" << length << " x " << elementType->toStr() << ">";
+    return buffer.str();
+}
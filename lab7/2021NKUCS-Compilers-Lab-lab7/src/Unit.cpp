@@ -1,5 +1,6 @@
 #include "Unit.h"
 #include <algorithm>
+#include <map>
 #include <stack>
 #include <string>
 #include "Ast.h"
@@ -11,6 +12,11 @@ void Unit::insertFunc(Function* f) {
     func_list.push_back(f);
 }
 
+// keep a function next to the one it was made from, callees stay before their callers.
+void Unit::insertFunc(Function* func, Function* after) {
+    func_list.insert(std::find(func_list.begin(), func_list.end(), after) + 1, func);
+}
+
 void Unit::removeFunc(Function* func) {
     func_list.erase(std::find(func_list.begin(), func_list.end(), func));
 }
@@ -19,6 +25,10 @@ void Unit::insertGlobal(SymbolEntry* se) {
     global_list.push_back(se);
 }
 
+void Unit::removeGlobal(SymbolEntry* se) {
+    global_list.erase(std::find(global_list.begin(), global_list.end(), se));
+}
+
 void Unit::insertDeclare(SymbolEntry* se) {
     auto it = std::find(declare_list.begin(), declare_list.end(), se);
     if (it == declare_list.end()) {
@@ -26,6 +36,15 @@ void Unit::insertDeclare(SymbolEntry* se) {
     }
 }
 
+SymbolEntry* Unit::declare(const std::string& name, Type* ret, const std::vector<Type*>& params) {
+    if (!routines.count(name)) {
+        Type* type = new FunctionType(ret, params, std::vector<SymbolEntry*>());
+        routines[name] = new IdentifierSymbolEntry(type, name, globals->getLevel(), -1, true);
+        insertDeclare(routines[name]);
+    }
+    return routines[name];
+}
+
 void Unit::output() const {
     for (auto se : global_list) {
         if (se->getType()->isInt())
@@ -35,7 +54,7 @@ void Unit::output() const {
         else if (se->getType()->isArray()) {
             ArrayType* type = (ArrayType*)(se->getType());
             // int size = type->getSize() / TypeSystem::intType->getSize();
-            int* val = ((IdentifierSymbolEntry*)se)->getArrayValue();
+            std::map<int, int>& val = ((IdentifierSymbolEntry*)se)->getArrayValues();
             int i = 0;
             fprintf(yyout, "%s = global ", se->toStr().c_str());
             if (((IdentifierSymbolEntry*)se)->isAllZero()) {
@@ -49,13 +68,20 @@ void Unit::output() const {
                 while (!stk.empty()) {
                     temp = stk.top();
                     if (temp->getElementType()->isInt()) {
-                        fprintf(yyout, "%s [", temp->toStr().c_str());
-                        for (int j = 0; j < temp->getLength(); j++) {
-                            if (j != 0)
-                                fprintf(yyout, ", ");
-                            fprintf(yyout, "i32 %d", val[i++]);
+                        auto it = val.lower_bound(i);
+                        if (it == val.end() || it->first >= i + temp->getLength()) {
+                            // a row without any non-zero element.
+                            fprintf(yyout, "%s zeroinitializer", temp->toStr().c_str());
+                            i += temp->getLength();
+                        } else {
+                            fprintf(yyout, "%s [", temp->toStr().c_str());
+                            for (int j = 0; j < temp->getLength(); j++) {
+                                if (j != 0)
+                                    fprintf(yyout, ", ");
+                                fprintf(yyout, "i32 %d", ((IdentifierSymbolEntry*)se)->getArrayValue(i++));
+                            }
+                            fprintf(yyout, "]");
                         }
-                        fprintf(yyout, "]");
                         stk1.pop();
                         stk.pop();
                         if (stk.empty())
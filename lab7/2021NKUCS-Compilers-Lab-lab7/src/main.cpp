@@ -2,8 +2,24 @@
 #include <unistd.h>
 #include <iostream>
 #include "Ast.h"
+#include "ConstGlobalFolding.h"
+#include "ConstantPropagation.h"
+#include "DeadArgumentElimination.h"
+#include "DeadCallElimination.h"
+#include "DeadGlobalElimination.h"
+#include "DeadStoreElimination.h"
+#include "GlobalPromotion.h"
+#include "GlobalValueNumbering.h"
+#include "Inliner.h"
 #include "LinearScan.h"
+#include "LoadElimination.h"
+#include "LoopVectorizer.h"
+#include "Memoizer.h"
 #include "MachineCode.h"
+#include "PartialRedundancyElimination.h"
+#include "SLPVectorizer.h"
+#include "Specializer.h"
+#include "TailRecursion.h"
 #include "Unit.h"
 using namespace std;
 
@@ -20,10 +36,12 @@ bool dump_tokens;
 bool dump_ast;
 bool dump_ir;
 bool dump_asm;
+bool memoize;
+int opt_level;
 
 int main(int argc, char* argv[]) {
     int opt;
-    while ((opt = getopt(argc, argv, "Siato:O::")) != -1) {
+    while ((opt = getopt(argc, argv, "Simato:O::")) != -1) {
         switch (opt) {
             case 'o':
                 strcpy(outfile, optarg);
@@ -40,8 +58,14 @@ int main(int argc, char* argv[]) {
             case 'S':
                 dump_asm = true;
                 break;
+            case 'm':
+                memoize = true;
+                break;
+            case 'O':
+                opt_level = optarg ? atoi(optarg) : 1;
+                break;
             default:
-                fprintf(stderr, "Usage: %s [-o outfile] infile\n", argv[0]);
+                fprintf(stderr, "Usage: %s [-o outfile] [-O[level]] [-m] infile\n", argv[0]);
                 exit(EXIT_FAILURE);
                 dump_asm = true;
                 break;
@@ -62,6 +86,48 @@ int main(int argc, char* argv[]) {
     }
     yyparse();
     ast.genCode(&unit);
+    if (opt_level > 0)
+    {
+        ConstGlobalFolding constGlobalFolding(&unit);
+        constGlobalFolding.pass();
+        TailRecursion tailRecursion(&unit);
+        tailRecursion.pass();
+        if (memoize)
+        {
+            Memoizer memoizer(&unit);
+            memoizer.pass();
+        }
+        Specializer specializer(&unit);
+        specializer.pass();
+        DeadCallElimination deadCallElimination(&unit);
+        deadCallElimination.pass();
+        DeadArgumentElimination deadArgumentElimination(&unit);
+        deadArgumentElimination.pass();
+        Inliner inliner(&unit);
+        inliner.pass();
+        ConstantPropagation constantPropagation(&unit);
+        constantPropagation.pass();
+        GlobalValueNumbering globalValueNumbering(&unit);
+        globalValueNumbering.pass();
+        LoadElimination loadElimination(&unit);
+        loadElimination.pass();
+        DeadStoreElimination deadStoreElimination(&unit);
+        deadStoreElimination.pass();
+        PartialRedundancyElimination partialRedundancyElimination(&unit);
+        partialRedundancyElimination.pass();
+        globalValueNumbering.pass();
+        DeadGlobalElimination deadGlobalElimination(&unit);
+        deadGlobalElimination.pass();
+        GlobalPromotion globalPromotion(&unit);
+        globalPromotion.pass();
+        // forwarded loads and promoted globals leave constants to fold.
+        constantPropagation.pass();
+        LoopVectorizer loopVectorizer(&unit);
+        loopVectorizer.pass();
+        SLPVectorizer slpVectorizer(&unit);
+        slpVectorizer.pass();
+        deadGlobalElimination.pass();
+    }
     unit.genMachineCode(&mUnit);
     LinearScan linearScan(&mUnit);
     linearScan.allocateRegisters();
@@ -10,13 +10,34 @@
     int yyerror(char const*);
     ArrayType* arrayType;
     int idx;
-    int* arrayValue;
+    std::map<int, int> arrayValue;  // the elements of the array being initialized, by index
     std::stack<InitValueListExpr*> stk;
+    std::stack<InitValueListExpr*> braces;  // the lists opened by an explicit '{'
     std::stack<StmtNode*> whileStk;
     InitValueListExpr* top;
-    int leftCnt = 0;
     int paramNo = 0;
     #include <iostream>
+
+    // int[d1][d2]... from the dimension list of a declaration.
+    ArrayType* buildArrayType(ExprNode* dims)
+    {
+        std::vector<int> vec;
+        ExprNode* temp = dims;
+        while(temp){
+            vec.push_back(temp->getValue());
+            temp = (ExprNode*)(temp->getNext());
+        }
+        Type *type = TypeSystem::intType;
+        Type* temp1;
+        while(!vec.empty()){
+            temp1 = new ArrayType(type, vec.back());
+            if(type->isArray())
+                ((ArrayType*)type)->setArrayType(temp1);
+            type = temp1;
+            vec.pop_back();
+        }
+        return (ArrayType*)type;
+    }
 }
 
 %code requires {
@@ -45,7 +66,7 @@
 %token RETURN CONTINUE BREAK
 
 %type<stmttype> Stmts Stmt AssignStmt ExprStmt BlockStmt IfStmt WhileStmt BreakStmt ContinueStmt ReturnStmt DeclStmt FuncDef ConstDeclStmt VarDeclStmt ConstDefList VarDef ConstDef VarDefList FuncFParam FuncFParams FuncFParamsPlus BlankStmt
-%type<exprtype> Exp AddExp Cond LOrExp PrimaryExp LVal RelExp LAndExp MulExp ConstExp EqExp UnaryExp InitVal ConstInitVal  FuncRParams Array FuncArray
+%type<exprtype> Exp AddExp Cond LOrExp PrimaryExp LVal RelExp LAndExp MulExp ConstExp EqExp UnaryExp InitVal InitValList ConstInitVal  FuncRParams Array FuncArray
 %type<type> Type
 
 %precedence THEN
@@ -338,31 +359,32 @@ VarDef
     }
     | ID Array {
         SymbolEntry* se;
-        std::vector<int> vec;
-        ExprNode* temp = $2;
-        while(temp){
-            vec.push_back(temp->getValue());
-            temp = (ExprNode*)(temp->getNext());
-        }
-        Type *type = TypeSystem::intType;
-        Type* temp1;
-        while(!vec.empty()){
-            temp1 = new ArrayType(type, vec.back());
-            if(type->isArray())
-                ((ArrayType*)type)->setArrayType(temp1);
-            type = temp1;
-            vec.pop_back();
-        }
+        Type* type = buildArrayType($2);
         arrayType = (ArrayType*)type;
         se = new IdentifierSymbolEntry(type, $1, identifiers->getLevel());
         ((IdentifierSymbolEntry*)se)->setAllZero();
-        int *p = new int[type->getSize()];
-        ((IdentifierSymbolEntry*)se)->setArrayValue(p);
         if(!identifiers->install($1, se))
             fprintf(stderr, "identifier \"%s\" is already defined\n", (char*)$1);
         $$ = new DeclStmt(new Id(se));
         delete []$1;
     }
+    | ID Array ASSIGN {
+        arrayType = buildArrayType($2);
+        arrayValue.clear();
+        idx = 0;
+    }
+      InitVal {
+        SymbolEntry* se;
+        se = new IdentifierSymbolEntry(arrayType, $1, identifiers->getLevel());
+        for(auto& it : arrayValue)
+            ((IdentifierSymbolEntry*)se)->setArrayValue(it.first, it.second);
+        if(((IdentifierSymbolEntry*)se)->getArrayValues().empty())
+            ((IdentifierSymbolEntry*)se)->setAllZero();
+        if(!identifiers->install($1, se))
+            fprintf(stderr, "identifier \"%s\" is already defined\n", (char*)$1);
+        $$ = new DeclStmt(new Id(se), $5);
+        delete []$1;
+    }
     | ID ASSIGN InitVal {
         SymbolEntry* se;
         se = new IdentifierSymbolEntry(TypeSystem::intType, $1, identifiers->getLevel());
@@ -382,6 +404,24 @@ ConstDef
         $$ = new DeclStmt(new Id(se), $3);
         delete []$1;
     }
+    | ID Array ASSIGN {
+        arrayType = buildArrayType($2);
+        arrayValue.clear();
+        idx = 0;
+    }
+      InitVal {
+        SymbolEntry* se;
+        se = new IdentifierSymbolEntry(arrayType, $1, identifiers->getLevel());
+        ((IdentifierSymbolEntry*)se)->setConst();
+        for(auto& it : arrayValue)
+            ((IdentifierSymbolEntry*)se)->setArrayValue(it.first, it.second);
+        if(((IdentifierSymbolEntry*)se)->getArrayValues().empty())
+            ((IdentifierSymbolEntry*)se)->setAllZero();
+        if(!identifiers->install($1, se))
+            fprintf(stderr, "identifier \"%s\" is already defined\n", (char*)$1);
+        $$ = new DeclStmt(new Id(se), $5);
+        delete []$1;
+    }
     ;
 Array
     : LBRACKET ConstExp RBRACKET 
@@ -418,7 +458,7 @@ InitVal
                     else
                     {
                         stk.top()->addExpr($1);
-                        while(stk.top()->isFull() && stk.size() != (long unsigned int)leftCnt)
+                        while(stk.top()->isFull() && stk.top() != braces.top())
                         {
                             arrTy = ((ArrayType*)arrTy)->getArrayType();
                             stk.pop();
@@ -428,6 +468,50 @@ InitVal
                 }
         }         
     }
+    | LBRACE RBRACE {
+        Type* type = arrayType;
+        if(!stk.empty())
+            type = ((ArrayType*)(stk.top()->getSymbolEntry()->getType()))->getElementType();
+        idx += type->getSize() / TypeSystem::intType->getSize();
+        if(type->isInt())
+            $$ = new Constant(new ConstantSymbolEntry(TypeSystem::intType, 0));
+        else
+            $$ = new InitValueListExpr(new ConstantSymbolEntry(type));
+        if(!stk.empty())
+        {
+            stk.top()->addExpr($$);
+            while(stk.top()->isFull() && stk.top() != braces.top())
+                stk.pop();
+        }
+    }
+    | LBRACE {
+        Type* type = arrayType;
+        if(!stk.empty())
+            type = ((ArrayType*)(stk.top()->getSymbolEntry()->getType()))->getElementType();
+        InitValueListExpr* list = new InitValueListExpr(new ConstantSymbolEntry(type));
+        if(!stk.empty())
+            stk.top()->addExpr(list);
+        stk.push(list);
+        braces.push(list);
+        $<exprtype>$ = list;
+    }
+      InitValList RBRACE {
+        // close the lists opened implicitly inside the braces.
+        while(stk.top() != braces.top())
+            stk.pop();
+        stk.pop();
+        braces.pop();
+        // the elements the braces leave out are zero.
+        int size = $<exprtype>2->getType()->getSize() / TypeSystem::intType->getSize();
+        idx = (idx + size - 1) / size * size;
+        while(!stk.empty() && stk.top()->isFull() && stk.top() != braces.top())
+            stk.pop();
+        $$ = $<exprtype>2;
+    }
+    ;
+InitValList
+    : InitVal {$$ = $1;}
+    | InitValList COMMA InitVal {$$ = $1;}
     ;
 ConstInitVal
     : ConstExp 
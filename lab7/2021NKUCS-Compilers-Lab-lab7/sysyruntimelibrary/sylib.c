@@ -2,6 +2,9 @@
 #include<stdarg.h>
 #include<sys/time.h>
 #include"sylib.h"
+#ifdef __ARM_NEON
+#include<arm_neon.h>
+#endif
 /* Input & output functions */
 int getint(){int t; scanf("%d",&t); return t; }
 int getch(){char c; scanf("%c",&c); return (int)c; }
@@ -19,6 +22,53 @@ void putarray(int n,int a[]){
   printf("\n");
 }
 
+/* Bulk memory functions */
+void _sysy_fill(int a[],int v,int n){
+  int i=0;
+#ifdef __ARM_NEON
+  int32x4_t q=vdupq_n_s32(v);
+  for(;i+8<=n;i+=8){ vst1q_s32(a+i,q); vst1q_s32(a+i+4,q); }
+#endif
+  for(;i<n;i++)a[i]=v;
+}
+/* front to back like the loop it replaces, also when dst overlaps src */
+void _sysy_copy(int dst[],int src[],int n){
+  int i=0;
+#ifdef __ARM_NEON
+  if(dst<=src||dst>=src+4)
+    for(;i+4<=n;i+=4)vst1q_s32(dst+i,vld1q_s32(src+i));
+#endif
+  for(;i<n;i++)dst[i]=src[i];
+}
+
+/* Results of memoized functions whose arguments miss the compiled table,
+   open addressing on (function, a, b); a full table just stops caching */
+#define _SYSY_MEMO 65536
+static int _sysy_memo_key[_SYSY_MEMO][3],_sysy_memo_val[_SYSY_MEMO],_sysy_memo_used[_SYSY_MEMO],_sysy_memo_last;
+static int _sysy_memo_slot(int f,int a,int b){
+  unsigned h=((unsigned)f*0x9e3779b1u)^((unsigned)a*0x85ebca6bu)^((unsigned)b*0xc2b2ae35u);
+  for(int n=0;n<_SYSY_MEMO;n++,h++){
+    int i=h&(_SYSY_MEMO-1);
+    if(!_sysy_memo_used[i]||(_sysy_memo_key[i][0]==f&&_sysy_memo_key[i][1]==a&&_sysy_memo_key[i][2]==b))
+      return i;
+  }
+  return -1;
+}
+int _sysy_memo_find(int f,int a,int b){
+  int i=_sysy_memo_slot(f,a,b);
+  if(i<0||!_sysy_memo_used[i])return 0;
+  _sysy_memo_last=_sysy_memo_val[i];
+  return 1;
+}
+int _sysy_memo_value(){ return _sysy_memo_last; }
+void _sysy_memo_put(int f,int a,int b,int v){
+  int i=_sysy_memo_slot(f,a,b);
+  if(i<0)return;
+  _sysy_memo_used[i]=1;
+  _sysy_memo_key[i][0]=f; _sysy_memo_key[i][1]=a; _sysy_memo_key[i][2]=b;
+  _sysy_memo_val[i]=v;
+}
+
 /* Timing function implementation */
 __attribute((constructor)) void before_main(){
   for(int i=0;i<_SYSY_N;i++)
@@ -7,6 +7,11 @@
 /* Input & output functions */
 int getint(),getch(),getarray(int a[]);
 void putint(int a),putch(int a),putarray(int n,int a[]);
+/* Bulk memory functions, called by compiled fill and copy loops */
+void _sysy_fill(int a[],int v,int n),_sysy_copy(int dst[],int src[],int n);
+/* Hash table behind memoized functions, find leaves a hit in value */
+int _sysy_memo_find(int f,int a,int b),_sysy_memo_value();
+void _sysy_memo_put(int f,int a,int b,int v);
 #define putf(fmt, ...) printf(fmt, __VA_ARGS__) // TODO? 
 /* Timing function implementation */
 struct timeval _sysy_start,_sysy_end;